@@ -0,0 +1,489 @@
+#!/usr/bin/env python3
+#
+# Generate variants of the vmull.p16 folding kernel and measure them, to
+# find which are worth their code size
+#
+# Each variant is written to crc32c_autotune.c, built with make, traced
+# with the same gdb flow as make count at each message size, and checked
+# against crc32c_naive. The variants are then ranked by code size and
+# weighted instruction count, and the Pareto-optimal ones (nothing both
+# smaller and faster) are marked.
+#
+# The axes:
+#
+# - distance     - bytes folded per loop iteration, 16/32/64
+# - accumulators - independent vector states, blocks are dealt out to them
+#                  round-robin, this must divide distance/16
+# - unroll       - loop iterations per loop check
+# - tail         - barret: Barret reduce whatever's left a word at a time
+#                  fold: fold any remaining 128-bit blocks first
+# - opt          - Os (make) or O3 (make FAST=1)
+#
+# Folds further than 128 bits need their own constants, and the 16-bit
+# overflow, which is already 128 bits ahead, needs a fold 128 bits shorter,
+# see longfold in crc32c_folding_vmullp16_3x8x16wide.c.
+#
+
+import itertools as it
+import os
+import re
+import string
+import subprocess
+import sys
+
+import constants as c
+
+
+POLYNOMIAL = 0x11edc6f41
+
+NAME = 'crc32c_autotune'
+
+DISTANCES = [16, 32, 64]
+ACCUMULATORS = [1, 2, 4]
+UNROLLS = [1, 2]
+TAILS = ['barret', 'fold']
+OPTS = ['Os', 'O3']
+SIZES = ['16', '64', '256', '1024', '4096']
+
+
+def k(n):
+    return c.brev(c.prem(1 << (n-1), POLYNOMIAL))
+
+def k16x2(bits):
+    # each 16-bit half of our 32-bit lanes needs its own constant
+    #
+    # k_lower = k(n+16)[15:0] << 16 | k(n+32)[15:0]
+    # k_upper = k(n+16)[31:16] << 16 | k(n+32)[31:16]
+    k16 = k(bits+16)
+    k32 = k(bits+32)
+    return ((k16 & 0xffff) << 16 | (k32 & 0xffff),
+            (k16 >> 16) << 16 | (k32 >> 16))
+
+
+HEADER = string.Template('''\
+// A crc32c implementation using polynomial folding leveraging ARMv8-M's MVE
+// vmull.p16 instruction, 8 16-bit halfwords at a time
+//
+// Generated by autotune.py, folds $distance bytes per iteration into
+// $accumulators accumulator(s), unrolled ${unroll}x, with a $tail tail
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <arm_mve.h>
+
+
+static inline uint32_t pmul32(uint32_t a, uint32_t b) {
+    uint16x8_t a_v = __arm_vdupq_n_u16(a);
+    uint16x8_t b_v = __arm_vdupq_n_u16(b);
+    a_v = (uint16x8_t)__arm_vsetq_lane_u32(a, (uint32x4_t)a_v, 1);
+    b_v = (uint16x8_t)__arm_vsetq_lane_u32(b, (uint32x4_t)b_v, 2);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(a_v, b_v);
+
+    return __arm_vgetq_lane_u32(x_v, 0)
+            ^ (__arm_vgetq_lane_u32(x_v, 1) << 16)
+            ^ (__arm_vgetq_lane_u32(x_v, 2) << 16);
+}
+
+// upper 32-bits of a 32x32 pmul, hi*hi ^ (hi*lo ^ lo*hi) >> 16
+static inline uint32_t pmul32_hi(uint32_t a, uint32_t b) {
+    uint32x4_t a_v = __arm_vdupq_n_u32(a);
+    uint32x4_t b_v = __arm_vdupq_n_u32(b);
+    a_v = __arm_vsetq_lane_u32(a << 16, a_v, 2);
+    b_v = __arm_vsetq_lane_u32(b << 16, b_v, 1);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)a_v, (uint16x8_t)b_v);
+
+    return __arm_vgetq_lane_u32(x_v, 0)
+            ^ (__arm_vgetq_lane_u32(x_v, 1) >> 16)
+            ^ (__arm_vgetq_lane_u32(x_v, 2) >> 16);
+}
+
+static inline uint32x4_t reduce8(uint32x4_t folded_v, uint8_t d) {
+    // Barret reduce 8-bit bytes
+    uint32_t crc = __arm_vgetq_lane_u32(folded_v, 0) ^ d;
+    uint32_t b = pmul32(crc << 24, 0xdea713f1);
+    crc = (crc >> 8) ^ pmul32_hi(b, 0x05ec76f1) ^ b;
+    return __arm_vsetq_lane_u32(crc, folded_v, 0);
+}
+
+static inline uint32x4_t reduce32(
+        uint32x4_t folded_v, uint32_t *overflow, uint32_t d) {
+    // Barret reduce 32-bit words
+    uint32_t crc = __arm_vgetq_lane_u32(folded_v, 0) ^ d;
+    uint32_t b = pmul32(crc, 0xdea713f1);
+    crc = __arm_vgetq_lane_u32(folded_v, 1) ^ pmul32_hi(b, 0x05ec76f1) ^ b;
+    folded_v = __arm_vsetq_lane_u32(crc, folded_v, 0);
+    folded_v = __arm_vsetq_lane_u32(
+            __arm_vgetq_lane_u32(folded_v, 2), folded_v, 1);
+    folded_v = __arm_vsetq_lane_u32(
+            __arm_vgetq_lane_u32(folded_v, 3), folded_v, 2);
+    folded_v = __arm_vsetq_lane_u32(*overflow, folded_v, 3);
+    *overflow = 0;
+    return folded_v;
+}
+
+static inline uint32x4_t fold128(
+        uint32x4_t folded_v, uint32_t *overflow,
+        uint32x4_t k_lower_v, uint32x4_t k_upper_v) {
+    // 2x p16xp32 -> p48 folds
+    uint32x4_t lower0_v = __arm_vmullbq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_lower_v);
+    uint32x4_t lower1_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_lower_v);
+    uint32x4_t upper0_v = __arm_vmullbq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_upper_v);
+    uint32x4_t upper1_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_upper_v);
+    // xor/shift into folded
+    uint32x4_t lower_v = __arm_veorq_u32(lower0_v, lower1_v);
+    uint32x4_t upper_v = __arm_veorq_u32(upper0_v, upper1_v);
+    return __arm_veorq_u32(lower_v,
+            __arm_vshlcq_u32(upper_v, overflow, 16));
+}
+
+// fold our state a long distance, the overflow is already 128-bits ahead
+// of folded, so it needs its own fold that is 128-bits shorter
+static inline uint32x4_t longfold(
+        uint32x4_t folded_v, uint32_t *overflow,
+        uint32x4_t k_lower_v, uint32x4_t k_upper_v,
+        uint32x4_t k_lower_short_v, uint32x4_t k_upper_short_v) {
+    uint32_t carry = 0;
+    uint32_t overflow_carry = 0;
+    folded_v = __arm_veorq_u32(
+            fold128(folded_v, &carry, k_lower_v, k_upper_v),
+            fold128(
+                __arm_vsetq_lane_u32(*overflow, __arm_vdupq_n_u32(0), 0),
+                &overflow_carry,
+                k_lower_short_v, k_upper_short_v));
+    *overflow = carry ^ overflow_carry;
+    return folded_v;
+}
+
+uint32_t $name(
+        uint32_t crc, const void *data, size_t size) {
+    const uint8_t *data_ = data;
+    crc = crc ^ 0xffffffff;
+
+$constants
+    uint32x4_t folded_v = __arm_vsetq_lane_u32(crc, __arm_vdupq_n_u32(0), 0);
+    uint32_t overflow = 0;
+
+    // bytes/words until aligned
+    size_t i = 0;
+    for (; i < size && ((uintptr_t)&data_[i]) % 4 != 0; i++) {
+        folded_v = reduce8(folded_v, data_[i]);
+    }
+    for (; i+4 <= size && ((uintptr_t)&data_[i]) % 16 != 0; i += 4) {
+        folded_v = reduce32(folded_v, &overflow, *(const uint32_t*)&data_[i]);
+    }
+
+''')
+
+FOLD_TAIL = '''\
+    // fold any remaining blocks, leaving the last 128-bits for the tail
+    for (; i+16+16 <= size; i += 16) {
+        folded_v = fold128(
+                __arm_veorq_u32(folded_v,
+                    __arm_vld1q_u32((const uint32_t*)&data_[i])),
+                &overflow, k128_lower_v, k128_upper_v);
+    }
+
+'''
+
+FOOTER = '''\
+    // trailing words/bytes
+    for (; i+4 <= size; i += 4) {
+        folded_v = reduce32(folded_v, &overflow, *(const uint32_t*)&data_[i]);
+    }
+    for (; i < size; i++) {
+        folded_v = reduce8(folded_v, data_[i]);
+    }
+
+    return __arm_vgetq_lane_u32(folded_v, 0) ^ 0xffffffff;
+}
+'''
+
+
+def generate(distance, accumulators, unroll, tail, name=NAME):
+    assert distance % 16 == 0, "distance must be a multiple of 16 bytes"
+    blocks = distance // 16
+    assert blocks % accumulators == 0, \
+        "accumulators must divide the blocks per iteration"
+    assert tail in TAILS, "unknown tail %r" % tail
+
+    # fold distances in bits we need constants for
+    ks = set()
+
+    def fold(expr, overflow, bits, indent):
+        # fold something with a pending overflow, 128-bit folds can just
+        # shift the overflow in with vshlc
+        ks.add(bits)
+        if bits == 128:
+            return ('fold128(\n%s%s,\n%s&%s, k128_lower_v, k128_upper_v)'
+                % (indent, expr, indent, overflow))
+        ks.add(bits-128)
+        return ('longfold(\n%s%s,\n%s&%s, k%d_lower_v, k%d_upper_v,\n'
+            '%sk%d_lower_v, k%d_upper_v)'
+                % (indent, expr, indent, overflow, bits, bits,
+                    indent, bits-128, bits-128))
+
+    def load(word):
+        return '__arm_vld1q_u32(&blocks[%d])' % word
+
+    def step(offset, indent):
+        # each accumulator owns every accumulators-th block, the first is
+        # xored into the accumulator, the others are folded the rest of
+        # the way to the next iteration independently
+        lines = []
+        for a in range(accumulators):
+            first = offset + a
+            lines.append('%sa%d_v = %s;' % (indent, a,
+                fold('__arm_veorq_u32(a%d_v, %s)' % (a, load(4*first)),
+                    'a%d_overflow' % a, 8*distance, indent+'        ')))
+            for b in range(first+accumulators, offset+blocks, accumulators):
+                bits = 8*distance - 128*(b-offset-a)
+                ks.add(bits)
+                lines.append('%scarry = 0;' % indent)
+                lines.append('%sa%d_v = __arm_veorq_u32(a%d_v, fold128(%s,\n'
+                    '%s        &carry, k%d_lower_v, k%d_upper_v));'
+                        % (indent, a, a, load(4*b), indent, bits, bits))
+                lines.append('%sa%d_overflow ^= carry;' % (indent, a))
+        return lines
+
+    carries = blocks // accumulators > 1
+
+    body = []
+    reserve = 16*accumulators
+    body.append('    // fold %d bytes per iteration into %d accumulator(s), '
+        'leaving\n    // the last 128-bits for the tail to reduce'
+            % (distance, accumulators))
+    body.append('    if (i+%d+%d <= size) {' % (distance, reserve))
+    body.append('        uint32x4_t a0_v = folded_v;')
+    body.append('        uint32_t a0_overflow = overflow;')
+    for a in range(1, accumulators):
+        body.append('        uint32x4_t a%d_v = __arm_vdupq_n_u32(0);' % a)
+        body.append('        uint32_t a%d_overflow = 0;' % a)
+    if carries:
+        body.append('        uint32_t carry;')
+    body.append('')
+
+    loops = [unroll, 1] if unroll > 1 else [unroll]
+    for u in loops:
+        if u != unroll:
+            body.append('        // leftover iterations')
+        body.append('        for (; i+%d+%d <= size; i += %d) {'
+            % (u*distance, reserve, u*distance))
+        body.append('            const uint32_t *blocks '
+            '= (const uint32_t*)&data_[i];')
+        for j in range(u):
+            body.extend(step(j*blocks, ' '*12))
+        body.append('        }')
+        body.append('')
+
+    # merge the accumulators into the last one, which also consumes the
+    # blocks the other accumulators are sitting on
+    if accumulators > 1:
+        body.append('        // merge accumulators, each folded the rest '
+            'of the way to the last')
+        body.append('        const uint32_t *blocks '
+            '= (const uint32_t*)&data_[i];')
+        last = accumulators-1
+        for a in range(last):
+            body.append('        a%d_v = %s;' % (a,
+                fold('__arm_veorq_u32(a%d_v, %s)' % (a, load(4*a)),
+                    'a%d_overflow' % a, 128*(last-a), ' '*16)))
+        accs = ['a%d_v' % a for a in range(accumulators)]
+        body.append('        folded_v = __arm_veorq_u32(\n'
+            '                %s,\n'
+            '                %s);' % (
+                veor(accs[:accumulators//2]),
+                veor(accs[accumulators//2:])))
+        body.append('        overflow = %s;' % ' ^ '.join(
+            'a%d_overflow' % a for a in range(accumulators)))
+        body.append('        i += %d;' % (16*last))
+    else:
+        body.append('        folded_v = a0_v;')
+        body.append('        overflow = a0_overflow;')
+    body.append('    }')
+    body.append('')
+
+    if tail == 'fold':
+        ks.add(128)
+
+    constants = []
+    for bits in sorted(ks):
+        lower, upper = k16x2(bits)
+        constants.append('    // fold by %d bits, k%d/k%d'
+            % (bits, bits+32, bits+16))
+        constants.append('    uint32x4_t k%d_lower_v = '
+            '__arm_vdupq_n_u32(0x%08x);' % (bits, lower))
+        constants.append('    uint32x4_t k%d_upper_v = '
+            '__arm_vdupq_n_u32(0x%08x);' % (bits, upper))
+
+    return (HEADER.substitute(
+            name=name,
+            distance=distance,
+            accumulators=accumulators,
+            unroll=unroll,
+            tail=tail,
+            constants='\n'.join(constants) + '\n')
+        + '\n'.join(body) + '\n'
+        + (FOLD_TAIL if tail == 'fold' else '')
+        + FOOTER)
+
+def veor(exprs):
+    # balanced xor tree, keeps the dependency chains short
+    if len(exprs) == 1:
+        return exprs[0]
+    mid = len(exprs) // 2
+    return '__arm_veorq_u32(%s, %s)' % (veor(exprs[:mid]), veor(exprs[mid:]))
+
+def variants(distances, accumulators, unrolls, tails):
+    for d, a, u, t in it.product(distances, accumulators, unrolls, tails):
+        if (d // 16) % a != 0:
+            continue
+        # a folded tail is a no-op if we already fold 16 bytes at a time
+        if t == 'fold' and d == 16:
+            continue
+        yield d, a, u, t
+
+def variant_name(distance, accumulators, unroll, tail, opt):
+    return 'd%d_a%d_u%d_%s_%s' % (distance, accumulators, unroll, tail, opt)
+
+
+# measuring
+def make(*args, **vars):
+    cmd = ['make', '-s'] + list(args) + [
+        '%s=%s' % (k, v) for k, v in vars.items() if v is not None]
+    return subprocess.run(cmd, check=True,
+        stdout=subprocess.PIPE, universal_newlines=True).stdout
+
+def measure(source, opt, sizes):
+    with open(NAME+'.c', 'w') as f:
+        f.write(source)
+
+    fast = '1' if opt == 'O3' else None
+    results = {}
+    for size, _ in sizes:
+        # main.o depends on DATA_SIZE, and we rebuild the kernel in case
+        # only opt changed
+        for path in ['main.o', NAME+'.o', NAME+'.trace']:
+            if os.path.exists(path):
+                os.remove(path)
+
+        out = make('run', CRCS=NAME+'.c', DATA_SIZE=size, FAST=fast)
+        m = re.search(r'^%s\s+=>\s+\S+( !)?$' % NAME, out, re.M)
+        if not m or m.group(1):
+            return None
+
+        out = make('count', CRCS=NAME+'.c', DATA_SIZE=size, FAST=fast)
+        m = re.search(r'^%s\s+(\d+)' % NAME, out, re.M)
+        results[size] = int(m.group(1))
+
+    out = make('size', OBJ=NAME+'.o', FAST=fast)
+    m = re.search(r'^\s*(\d+)\s+\d+\s+\d+\s+\d+\s+\S+\s+%s\.o$' % NAME,
+        out, re.M)
+    return int(m.group(1)), results
+
+def pareto(results):
+    # smallest first, anything that isn't faster than everything smaller
+    # is dominated
+    best = None
+    optimal = set()
+    for name, (code, ins) in sorted(results.items(),
+            key=lambda x: (x[1][0], x[1][1])):
+        if best is None or ins < best:
+            optimal.add(name)
+            best = ins
+    return optimal
+
+def parse_size(s):
+    size, _, weight = s.partition(':')
+    return int(size), float(weight or 1)
+
+
+def main(distances, accumulators, unrolls, tails, opts, sizes,
+        emit=None, all=False):
+    sizes = [parse_size(s) for s in sizes]
+
+    if emit:
+        d, a, u, t = emit.split(',')
+        sys.stdout.write(generate(int(d), int(a), int(u), t))
+        return
+
+    results = {}
+    per_size = {}
+    try:
+        for d, a, u, t in variants(distances, accumulators, unrolls, tails):
+            source = generate(d, a, u, t)
+            for opt in opts:
+                name = variant_name(d, a, u, t, opt)
+                print('measuring %s...' % name, file=sys.stderr)
+                r = measure(source, opt, sizes)
+                if r is None:
+                    print('warning: %s gave the wrong crc32c, skipping'
+                        % name, file=sys.stderr)
+                    continue
+                code, counts = r
+                # weighted mean instructions per call
+                ins = (sum(w*counts[s] for s, w in sizes)
+                    / sum(w for _, w in sizes))
+                results[name] = (code, ins)
+                per_size[name] = counts
+    finally:
+        # impls.py.c/main only know about our generated kernel, and would
+        # look up to date to make, so these need to go too
+        for path in [NAME+'.c', NAME+'.o', NAME+'.d', NAME+'.ci',
+                NAME+'.trace', 'main', 'main.o',
+                'impls.py.c', 'impls.py.o', 'impls.py.d', 'impls.py.ci']:
+            if os.path.exists(path):
+                os.remove(path)
+
+    optimal = pareto(results)
+    print('%-28s %7s %9s %s' % (
+        '', 'code', 'ins',
+        ' '.join('%7s' % ('@%d' % s) for s, _ in sizes)))
+    for name, (code, ins) in sorted(results.items(),
+            key=lambda x: (x[1][0], x[1][1])):
+        if not all and name not in optimal:
+            continue
+        print('%-28s %7d %9.1f %s%s' % (
+            name, code, ins,
+            ' '.join('%7d' % per_size[name][s] for s, _ in sizes),
+            ' *' if all and name in optimal else ''))
+
+
+if __name__ == "__main__":
+    import argparse
+    parser = argparse.ArgumentParser(
+        description="Generate and measure folding kernel variants, showing "
+            "the Pareto-optimal ones for code size vs instructions.")
+    parser.add_argument('-d', '--distance', dest='distances', type=int,
+        nargs='+', default=DISTANCES,
+        help="Bytes folded per iteration, defaults to %s." % DISTANCES)
+    parser.add_argument('-a', '--accumulators', type=int,
+        nargs='+', default=ACCUMULATORS,
+        help="Accumulator counts, defaults to %s." % ACCUMULATORS)
+    parser.add_argument('-u', '--unroll', dest='unrolls', type=int,
+        nargs='+', default=UNROLLS,
+        help="Unroll factors, defaults to %s." % UNROLLS)
+    parser.add_argument('-t', '--tail', dest='tails',
+        nargs='+', choices=TAILS, default=TAILS,
+        help="Tail strategies, defaults to %s." % TAILS)
+    parser.add_argument('-O', '--opt', dest='opts',
+        nargs='+', choices=OPTS, default=OPTS,
+        help="Optimization levels, O3 builds with FAST=1, defaults to %s."
+            % OPTS)
+    parser.add_argument('-s', '--size', dest='sizes',
+        nargs='+', default=SIZES,
+        help="Message sizes to measure, each size can have a weight, "
+            "size:weight, for the mean. Defaults to %s." % SIZES)
+    parser.add_argument('-e', '--emit',
+        help="Just print the source for one variant, "
+            "distance,accumulators,unroll,tail.")
+    parser.add_argument('-A', '--all', action='store_true',
+        help="Show all variants, marking the Pareto-optimal ones with *.")
+    sys.exit(main(**vars(parser.parse_args())))
@@ -0,0 +1,389 @@
+#!/usr/bin/env python3
+#
+# Generate the crc32c_bitsliced_* kernels, these are all the same algorithm,
+# just with a different number of slices and different word types to store
+# the slices in
+#
+# Each of the 64 rows of bits is stored in slices/width words, so for
+# example 256 slices with 128-bit MVE words is 2 MVE words per row.
+#
+
+import os
+import string
+import constants as c
+
+
+POLYNOMIAL = 0x11edc6f41
+
+# word widths -> C types
+TYPES = {
+    32: 'uint32_t',
+    64: 'uint64_t',
+    128: 'uint32x4_t',
+}
+
+# default word width for each slice count
+WIDTHS = {
+    32: 32,
+    64: 64,
+    128: 128,
+    256: 128,
+}
+
+
+def k(n):
+    return c.brev(c.prem(1 << (n-1), POLYNOMIAL))
+
+
+HEADER = string.Template('''\
+// A crc32c implementation using a bitsliced polynomial multiplication
+// to fold $slices pairs of 32-bit words ($block bytes) at a time$mve_note
+//
+// Generated by bitsliced.py, $slices slices stored in $words $width-bit
+// word(s) per bit
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <arm_mve.h>
+
+
+static inline uint64_t pmul32(uint32_t a, uint32_t b) {
+    uint16x8_t a_v = __arm_vdupq_n_u16(a);
+    uint16x8_t b_v = __arm_vdupq_n_u16(b);
+    a_v = (uint16x8_t)__arm_vsetq_lane_u32(a, (uint32x4_t)a_v, 1);
+    a_v = (uint16x8_t)__arm_vsetq_lane_u32(a, (uint32x4_t)a_v, 3);
+    b_v = (uint16x8_t)__arm_vsetq_lane_u32(b, (uint32x4_t)b_v, 2);
+    b_v = (uint16x8_t)__arm_vsetq_lane_u32(b, (uint32x4_t)b_v, 3);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(a_v, b_v);
+
+    return ((uint64_t)__arm_vgetq_lane_u32(x_v, 0))
+         ^ ((uint64_t)__arm_vgetq_lane_u32(x_v, 1) << 16)
+         ^ ((uint64_t)__arm_vgetq_lane_u32(x_v, 2) << 16)
+         ^ ((uint64_t)__arm_vgetq_lane_u32(x_v, 3) << 32);
+}
+
+// words per row of bits
+#define WORDS $words
+
+static inline void bitsliced_xorpmul${slices}x64(
+        $type d[static restrict 64*WORDS],
+        const $type a[static restrict 32*WORDS],
+        uint32_t k) {
+    for (size_t i = 0; i < 32; i++) {
+        if (k & (1 << i)) {
+            for (size_t j = 0; j < 32*WORDS; j++) {
+                $xorpmul
+            }
+        }
+    }
+}
+
+static inline void bitsliced_zero${slices}x64(
+        $type d[static restrict 64*WORDS]) {
+    memset(d, 0, 64*WORDS*sizeof($type));
+}
+''')
+
+# slice i is bit i of word i/width, shifting moves everything towards
+# slice 0
+SCALAR = string.Template('''
+static inline uint32_t bitsliced_get32(
+        const $type d[static restrict 32*WORDS]) {
+    uint32_t r = 0;
+    for (size_t j = 0; j < 32; j++) {
+        r |= (uint32_t)(d[j*WORDS] & 1) << j;
+    }
+    return r;
+}
+
+static inline void bitsliced_set32(
+        $type d[static restrict 64*WORDS],
+        uint32_t r) {
+    for (size_t j = 0; j < 32; j++) {
+         d[j*WORDS] = (r >> j) & 1;
+    }
+}
+
+static inline void bitsliced_xorload${slices}x64(
+        $type d[static restrict 64*WORDS],
+        const uint64_t s[static restrict $slices]) {
+    const uint32_t *restrict s_ = (const uint32_t *restrict)s;
+    for (size_t j = 0; j < 64; j++) {
+        for (size_t w = 0; w < WORDS; w++) {
+            $type r = d[j*WORDS+w];
+            for (size_t i = 0; i < $width; i++) {
+                r ^= ($type)((s_[2*($width*w+i)+(j/32)] >> (j%32)) & 1) << i;
+            }
+            d[j*WORDS+w] = r;
+        }
+    }
+}
+
+static inline void bitsliced_xorshr64(
+        $type d[static restrict 64*WORDS],
+        uint64_t r) {
+    for (size_t j = 0; j < 64; j++) {
+        for (size_t w = 0; w < WORDS-1; w++) {
+            d[j*WORDS+w] = (d[j*WORDS+w] >> 1)
+                    | (d[j*WORDS+w+1] << ($width-1));
+        }
+        d[j*WORDS+WORDS-1] >>= 1;
+        d[j*WORDS] ^= (r >> j) & 1;
+    }
+}
+
+static inline void bitsliced_xorshr32(
+        $type d[static restrict 64*WORDS],
+        uint32_t r) {
+    for (size_t j = 0; j < 32; j++) {
+        for (size_t w = 0; w < WORDS; w++) {
+            d[j*WORDS+w] = d[(j+32)*WORDS+w];
+        }
+        d[j*WORDS] ^= (r >> j) & 1;
+    }
+
+    memset(&d[32*WORDS], 0, 32*WORDS*sizeof($type));
+}
+''')
+
+# slice i is stored bit-reversed, in bit 127-i%128 of word WORDS-1-i/128,
+# this lets us take advantage of the vshlc instruction
+MVE = string.Template('''
+static inline uint32_t bitsliced_get32(
+        const uint32x4_t d[static restrict 32*WORDS]) {
+    uint32_t r = 0;
+    for (size_t j = 0; j < 32; j++) {
+        r |= (((const uint32_t*)&d[j*WORDS+WORDS-1])[3] >> 31) << j;
+    }
+    return r;
+}
+
+static inline void bitsliced_set32(
+        uint32x4_t d[static restrict 64*WORDS],
+        uint32_t r) {
+    for (size_t j = 0; j < 32; j++) {
+         ((uint32_t*)&d[j*WORDS+WORDS-1])[3] = (r >> j) << 31;
+    }
+}
+
+static inline void bitsliced_xorload${slices}x64(
+        uint32x4_t d[static restrict 64*WORDS],
+        const uint64_t s[static restrict $slices]) {
+    // note we can't use 8-bit offsets here because our range doesn't
+    // actually fit
+    // offs_v = [14*8*8 12*8*8 10*8*8... 0*8*8]
+    uint16x8_t offs_v = __arm_vshlq_n_u16(__arm_vddupq_n_u16(14, 2), 6);
+
+    // use gathers to transpose lanes, transpose bits in lane manually,
+    // each word holds 128 slices
+    for (size_t w = 0; w < WORDS; w++) {
+        const uint8_t *restrict s_
+                = (const uint8_t *restrict)&s[128*(WORDS-1-w)];
+        for (size_t j = 0; j < 64; j++) {
+            uint8x16_t r = (uint8x16_t)d[j*WORDS+w];
+            for (size_t i = 0; i < 8; i++) {
+                uint8x16_t x = (uint8x16_t)__arm_vsliq_n_u16(
+                        __arm_vldrhq_gather_offset_u16(
+                            (const uint16_t *restrict)&s_[8*(i+8)+(j/8)],
+                            offs_v),
+                        __arm_vldrhq_gather_offset_u16(
+                            (const uint16_t *restrict)&s_[8*(i+0)+(j/8)],
+                            offs_v),
+                        8);
+                // two-shifts to mask, since there's no single-bit and
+                // immediate
+                r = __arm_veorq_u8(
+                        r,
+                        __arm_vshlq_r_u8(
+                            __arm_vshrq_n_u8(
+                                __arm_vshlq_r_u8(x, 7-(j%8)),
+                                7),
+                            7-i));
+            }
+            d[j*WORDS+w] = (uint32x4_t)r;
+        }
+    }
+}
+
+static inline void bitsliced_xorshr64(
+        uint32x4_t d[static restrict 64*WORDS],
+        uint64_t r) {
+    for (size_t j = 0; j < 64; j++) {
+        uint32_t carry = 0;
+        for (size_t w = 0; w < WORDS; w++) {
+            d[j*WORDS+w] = __arm_vshlcq_u32(d[j*WORDS+w], &carry, 1);
+        }
+        uint32x4_t x = __arm_vdupq_n_u32(((r >> j) << 31));
+        uint32x4_t s = d[j*WORDS+WORDS-1];
+        d[j*WORDS+WORDS-1] = __arm_veorq_m_u32(s, s, x, 0xf000);
+    }
+}
+
+static inline void bitsliced_xorshr32(
+        uint32x4_t d[static restrict 64*WORDS],
+        uint32_t r) {
+    for (size_t j = 0; j < 32; j++) {
+        for (size_t w = 0; w < WORDS; w++) {
+            d[j*WORDS+w] = d[(j+32)*WORDS+w];
+        }
+        uint32x4_t x = __arm_vdupq_n_u32(((r >> j) << 31));
+        uint32x4_t s = d[j*WORDS+WORDS-1];
+        d[j*WORDS+WORDS-1] = __arm_veorq_m_u32(s, s, x, 0xf000);
+    }
+
+    memset(&d[32*WORDS], 0, 32*WORDS*sizeof(uint32x4_t));
+}
+''')
+
+FOOTER = string.Template('''
+static inline void bitsliced_fold64(
+        $type d[static restrict 64*WORDS],
+        uint64_t r) {
+    uint64_t folded
+            = pmul32(
+                bitsliced_get32(&d[0]) ^ (uint32_t)r,
+                $k96)
+            ^ pmul32(
+                bitsliced_get32(&d[32*WORDS]) ^ (uint32_t)(r >> 32),
+                $k64);
+    bitsliced_xorshr64(d, folded);
+}
+
+static inline void bitsliced_reduce32(
+        $type d[static restrict 64*WORDS],
+        uint32_t r) {
+    uint32_t crc = bitsliced_get32(d) ^ r;
+    uint32_t b = (uint32_t)pmul32(crc, $barret_r);
+    bitsliced_xorshr32(d,
+            (uint32_t)(pmul32(b, $polynomial_r) >> 32)
+            ^ b);
+}
+
+static inline void bitsliced_reduce8(
+        $type d[static restrict 64*WORDS],
+        uint8_t r) {
+    uint32_t crc = bitsliced_get32(d) ^ r;
+    uint32_t b = (uint32_t)pmul32(crc << 24, $barret_r);
+    bitsliced_set32(d, (crc >> 8)
+            ^ (uint32_t)(pmul32(b, $polynomial_r) >> 32)
+            ^ b);
+}
+
+uint32_t ${name}(
+        uint32_t crc, const void *data, size_t size) {
+    const uint8_t *data_ = data;
+
+    // two buffers to alternate between
+    $type slices[2][64*WORDS] = $init;
+    bool flip = false;
+
+    bitsliced_set32(slices[flip], crc ^ 0xffffffff);
+
+    // bytes/words/64-bit folds until aligned
+    size_t i = 0;
+    for (; i < size && ((uintptr_t)&data_[i]) % 4 != 0; i++) {
+        bitsliced_reduce8(slices[flip], data_[i]);
+    }
+    for (; i+4 <= size && ((uintptr_t)&data_[i]) % 8 != 0; i += 4) {
+        bitsliced_reduce32(slices[flip], *(const uint32_t*)&data_[i]);
+    }
+    for (; i+8+8 <= size && ((uintptr_t)&data_[i]) % $block != 0; i += 8) {
+        bitsliced_fold64(slices[flip], *(const uint64_t*)&data_[i]);
+    }
+
+    // aligned bitsliced folds, leaving the last $block bytes for the tail
+    // to reduce
+    if (i+$block+$block <= size) {
+        const uint64_t *blocks = (const uint64_t*)&data_[i];
+        size_t count = (size-$block - i) / $block;
+        for (size_t j = 0; j < count; j++) {
+            // xor data into folded
+            bitsliced_xorload${slices}x64(slices[flip], &blocks[$slices*j]);
+            // fold with 2 32x32 pmuls, note these already xor
+            bitsliced_zero${slices}x64(slices[!flip]);
+            bitsliced_xorpmul${slices}x64(slices[!flip],
+                    &slices[flip][ 0], $k_lower);
+            bitsliced_xorpmul${slices}x64(slices[!flip],
+                    &slices[flip][32*WORDS], $k_upper);
+            flip = !flip;
+        }
+        i += $block*count;
+    }
+
+    // trailing 64-bit folds/words/bytes
+    for (; i+8+8 <= size; i += 8) {
+        bitsliced_fold64(slices[flip], *(const uint64_t*)&data_[i]);
+    }
+    for (; i+4 <= size; i += 4) {
+        bitsliced_reduce32(slices[flip], *(const uint32_t*)&data_[i]);
+    }
+    for (; i < size; i++) {
+        bitsliced_reduce8(slices[flip], data_[i]);
+    }
+
+    return bitsliced_get32(slices[flip]) ^ 0xffffffff;
+}
+''')
+
+
+def generate(name, slices, width):
+    assert width in TYPES, "unsupported width %d" % width
+    assert slices % width == 0, "slices must be a multiple of width"
+    params = dict(
+        name=name,
+        slices=slices,
+        width=width,
+        words=slices // width,
+        block=slices*8,
+        type=TYPES[width],
+        xorpmul=('d[j+i*WORDS] = __arm_veorq_u32(d[j+i*WORDS], a[j]);'
+            if width == 128 else 'd[j+i*WORDS] ^= a[j];'),
+        init='{0}' if width == 128 else '{{0}, {0}}',
+        mve_note=(', leveraging\n'
+            '// ARMv8-M\'s MVE SIMD registers to operate on 128 bitsliced '
+            'bits\n// simultaneously.' if width == 128 else ''),
+        # each fold moves our 2x32-bit words by slices*64 bits
+        k_lower='0x%08x' % k(slices*64+32),
+        k_upper='0x%08x' % k(slices*64),
+        k96='0x%08x' % k(96),
+        k64='0x%08x' % k(64),
+        barret_r='0x%08x' % c.brev(c.pdiv(1 << 64, POLYNOMIAL) >> 1),
+        polynomial_r='0x%08x' % c.brev(POLYNOMIAL >> 1),
+    )
+
+    return (HEADER.substitute(params)
+        + (MVE if width == 128 else SCALAR).substitute(params)
+        + FOOTER.substitute(params))
+
+def main(slices, width=None, output=None):
+    for slices_ in slices:
+        width_ = width or WIDTHS.get(slices_, 128)
+        # non-default widths get their own file, so they don't overwrite
+        # the default kernels
+        path = output or 'crc32c_bitsliced_%dx2x32wide%s.c' % (
+            slices_,
+            '_%dbit' % width_ if width_ != WIDTHS.get(slices_, 128) else '')
+        # impls.py names kernels after their file
+        name = os.path.splitext(os.path.basename(path))[0]
+        with open(path, 'w') as f:
+            f.write(generate(name, slices_, width_))
+
+
+if __name__ == "__main__":
+    import argparse
+    import sys
+    parser = argparse.ArgumentParser(
+        description="Generate bitsliced crc32c kernels.")
+    parser.add_argument('slices', nargs='*', type=int,
+        default=sorted(WIDTHS.keys()),
+        help="Number of slices, defaults to %s." % sorted(WIDTHS.keys()))
+    parser.add_argument('-w', '--width', type=int,
+        help="Word width to store slices in, one of %s. Defaults to %s."
+            % (sorted(TYPES.keys()), WIDTHS))
+    parser.add_argument('-o', '--output',
+        help="Output file, defaults to crc32c_bitsliced_<slices>x2x32wide.c, "
+            "with a _<width>bit suffix for non-default widths.")
+    sys.exit(main(**vars(parser.parse_args())))
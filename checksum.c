@@ -0,0 +1,406 @@
+// A Linux command-line tool to crc32c files, comparing different I/O
+// strategies
+//
+// This is built for the host, not the M55, with `make checksum`. It uses
+// the fastest crc32c the host has, the SSE4.2/ARMv8 crc32c instructions
+// if available, otherwise slicing-by-8 tables, which produce the same
+// crc32c as the device kernels.
+//
+// Modes:
+// - mmap   - mmap the whole file with madvise(MADV_SEQUENTIAL)
+// - read   - read() into a large buffer
+// - thread - a reader thread feeding a crc thread through a ring of
+//            buffers, so I/O and the crc32c overlap
+//
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+
+//// host crc32c ////
+
+#if defined(__SSE4_2__) || defined(__ARM_FEATURE_CRC32)
+static const char *crc32c_name = "hw";
+
+static inline uint32_t crc32c_hw8(uint32_t crc, uint8_t d) {
+#if defined(__SSE4_2__)
+    return _mm_crc32_u8(crc, d);
+#else
+    return __crc32cb(crc, d);
+#endif
+}
+
+static inline uint32_t crc32c_hw64(uint32_t crc, uint64_t d) {
+#if defined(__SSE4_2__) && defined(__x86_64__)
+    return (uint32_t)_mm_crc32_u64(crc, d);
+#elif defined(__SSE4_2__)
+    crc = _mm_crc32_u32(crc, (uint32_t)d);
+    return _mm_crc32_u32(crc, (uint32_t)(d >> 32));
+#else
+    return __crc32cd(crc, d);
+#endif
+}
+
+static void crc32c_init(void) {
+}
+
+static uint32_t crc32c(uint32_t crc, const void *data, size_t size) {
+    const uint8_t *data_ = data;
+    crc = crc ^ 0xffffffff;
+
+    size_t i = 0;
+    for (; i < size && ((uintptr_t)&data_[i]) % 8 != 0; i++) {
+        crc = crc32c_hw8(crc, data_[i]);
+    }
+    for (; i+8 <= size; i += 8) {
+        crc = crc32c_hw64(crc, *(const uint64_t*)&data_[i]);
+    }
+    for (; i < size; i++) {
+        crc = crc32c_hw8(crc, data_[i]);
+    }
+
+    return crc ^ 0xffffffff;
+}
+
+#else
+static const char *crc32c_name = "slicing-by-8";
+
+static uint32_t TABLE[8][256];
+
+static void crc32c_init(void) {
+    for (size_t i = 0; i < 256; i++) {
+        uint32_t x = i;
+        for (size_t j = 0; j < 8; j++) {
+            x = (x >> 1) ^ ((x & 1) ? 0x82f63b78 : 0);
+        }
+        TABLE[0][i] = x;
+    }
+    for (size_t i = 0; i < 256; i++) {
+        for (size_t k = 1; k < 8; k++) {
+            TABLE[k][i] = (TABLE[k-1][i] >> 8)
+                    ^ TABLE[0][TABLE[k-1][i] & 0xff];
+        }
+    }
+}
+
+static uint32_t crc32c(uint32_t crc, const void *data, size_t size) {
+    const uint8_t *data_ = data;
+    crc = crc ^ 0xffffffff;
+
+    size_t i = 0;
+    for (; i < size && ((uintptr_t)&data_[i]) % 8 != 0; i++) {
+        crc = (crc >> 8) ^ TABLE[0][(crc ^ data_[i]) & 0xff];
+    }
+    for (; i+8 <= size; i += 8) {
+        uint32_t lo = crc ^ *(const uint32_t*)&data_[i+0];
+        uint32_t hi = *(const uint32_t*)&data_[i+4];
+        crc = TABLE[7][(lo >>  0) & 0xff]
+                ^ TABLE[6][(lo >>  8) & 0xff]
+                ^ TABLE[5][(lo >> 16) & 0xff]
+                ^ TABLE[4][(lo >> 24) & 0xff]
+                ^ TABLE[3][(hi >>  0) & 0xff]
+                ^ TABLE[2][(hi >>  8) & 0xff]
+                ^ TABLE[1][(hi >> 16) & 0xff]
+                ^ TABLE[0][(hi >> 24) & 0xff];
+    }
+    for (; i < size; i++) {
+        crc = (crc >> 8) ^ TABLE[0][(crc ^ data_[i]) & 0xff];
+    }
+
+    return crc ^ 0xffffffff;
+}
+#endif
+
+
+//// I/O strategies ////
+
+static size_t buffer_size = 1024*1024;
+static size_t ring_size = 4;
+
+static int checksum_mmap(int fd, size_t size, uint32_t *crc) {
+    if (size == 0) {
+        *crc = crc32c(0, NULL, 0);
+        return 0;
+    }
+
+    void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        return -errno;
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    *crc = crc32c(0, data, size);
+
+    munmap(data, size);
+    return 0;
+}
+
+static int checksum_read(int fd, size_t size, uint32_t *crc) {
+    (void)size;
+    uint8_t *buffer = malloc(buffer_size);
+    if (!buffer) {
+        return -ENOMEM;
+    }
+
+    uint32_t crc_ = 0;
+    while (true) {
+        ssize_t d = read(fd, buffer, buffer_size);
+        if (d < 0) {
+            int err = -errno;
+            free(buffer);
+            return err;
+        } else if (d == 0) {
+            break;
+        }
+
+        crc_ = crc32c(crc_, buffer, d);
+    }
+
+    free(buffer);
+    *crc = crc_;
+    return 0;
+}
+
+// a ring of buffers between the reader and crc threads, the reader fills
+// slots at head, the crc thread drains them at tail
+struct ring {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint8_t **buffers;
+    size_t *sizes;
+    size_t head;
+    size_t tail;
+    bool done;
+    int err;
+    int fd;
+};
+
+static void *reader(void *arg) {
+    struct ring *r = arg;
+    while (true) {
+        // wait for a free slot
+        pthread_mutex_lock(&r->lock);
+        while (r->head - r->tail == ring_size) {
+            pthread_cond_wait(&r->cond, &r->lock);
+        }
+        size_t slot = r->head % ring_size;
+        pthread_mutex_unlock(&r->lock);
+
+        ssize_t d = read(r->fd, r->buffers[slot], buffer_size);
+
+        pthread_mutex_lock(&r->lock);
+        if (d <= 0) {
+            r->err = (d < 0) ? -errno : 0;
+            r->done = true;
+            pthread_cond_broadcast(&r->cond);
+            pthread_mutex_unlock(&r->lock);
+            return NULL;
+        }
+        r->sizes[slot] = d;
+        r->head += 1;
+        pthread_cond_broadcast(&r->cond);
+        pthread_mutex_unlock(&r->lock);
+    }
+}
+
+static int checksum_thread(int fd, size_t size, uint32_t *crc) {
+    (void)size;
+    struct ring r = {
+        .lock = PTHREAD_MUTEX_INITIALIZER,
+        .cond = PTHREAD_COND_INITIALIZER,
+        .fd = fd,
+    };
+    r.buffers = calloc(ring_size, sizeof(uint8_t*));
+    r.sizes = calloc(ring_size, sizeof(size_t));
+    int err = (r.buffers && r.sizes) ? 0 : -ENOMEM;
+    for (size_t i = 0; !err && i < ring_size; i++) {
+        r.buffers[i] = malloc(buffer_size);
+        if (!r.buffers[i]) {
+            err = -ENOMEM;
+        }
+    }
+    if (err) {
+        goto cleanup;
+    }
+
+    pthread_t thread;
+    err = -pthread_create(&thread, NULL, reader, &r);
+    if (err) {
+        goto cleanup;
+    }
+
+    // crc slots as they fill
+    uint32_t crc_ = 0;
+    while (true) {
+        pthread_mutex_lock(&r.lock);
+        while (r.head == r.tail && !r.done) {
+            pthread_cond_wait(&r.cond, &r.lock);
+        }
+        if (r.head == r.tail) {
+            pthread_mutex_unlock(&r.lock);
+            break;
+        }
+        size_t slot = r.tail % ring_size;
+        pthread_mutex_unlock(&r.lock);
+
+        crc_ = crc32c(crc_, r.buffers[slot], r.sizes[slot]);
+
+        pthread_mutex_lock(&r.lock);
+        r.tail += 1;
+        pthread_cond_broadcast(&r.cond);
+        pthread_mutex_unlock(&r.lock);
+    }
+
+    pthread_join(thread, NULL);
+    err = r.err;
+    *crc = crc_;
+
+cleanup:
+    for (size_t i = 0; r.buffers && i < ring_size; i++) {
+        free(r.buffers[i]);
+    }
+    free(r.buffers);
+    free(r.sizes);
+    return err;
+}
+
+static const struct mode {
+    const char *name;
+    int (*checksum)(int fd, size_t size, uint32_t *crc);
+} MODES[] = {
+    {"mmap",   checksum_mmap},
+    {"read",   checksum_read},
+    {"thread", checksum_thread},
+};
+
+
+//// entry point ////
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-m mode] [-b bytes] [-n buffers] "
+            "files...\n", name);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  -m mode     One of mmap, read, thread, or all. "
+            "Defaults to all.\n");
+    fprintf(stderr, "  -b bytes    Buffer size for read/thread. "
+            "Defaults to %zu.\n", buffer_size);
+    fprintf(stderr, "  -n buffers  Ring size for thread. "
+            "Defaults to %zu.\n", ring_size);
+}
+
+int main(int argc, char **argv) {
+    const char *mode = "all";
+    int opt;
+    while ((opt = getopt(argc, argv, "m:b:n:h")) != -1) {
+        switch (opt) {
+            case 'm': mode = optarg; break;
+            case 'b': buffer_size = strtoull(optarg, NULL, 0); break;
+            case 'n': ring_size = strtoull(optarg, NULL, 0); break;
+            default: usage(argv[0]); return (opt == 'h') ? 0 : 1;
+        }
+    }
+    if (optind >= argc || buffer_size == 0 || ring_size == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    size_t mode_count = sizeof(MODES)/sizeof(MODES[0]);
+    bool found = (strcmp(mode, "all") == 0);
+    for (size_t m = 0; m < mode_count; m++) {
+        if (strcmp(mode, MODES[m].name) == 0) {
+            found = true;
+        }
+    }
+    if (!found) {
+        fprintf(stderr, "unknown mode \"%s\"\n", mode);
+        return 1;
+    }
+
+    crc32c_init();
+
+    // totals per mode, so we can report GB/s over all files
+    double times[sizeof(MODES)/sizeof(MODES[0])] = {0};
+    uint64_t totals[sizeof(MODES)/sizeof(MODES[0])] = {0};
+    int ret = 0;
+
+    printf("%-8s %-6s %10s %9s  %s\n", "crc32c", "mode", "bytes", "GB/s",
+            "path");
+    for (int i = optind; i < argc; i++) {
+        int fd = open(argv[i], O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) < 0) {
+            fprintf(stderr, "%s: %s\n", argv[i], strerror(errno));
+            ret = 1;
+            if (fd >= 0) {
+                close(fd);
+            }
+            continue;
+        }
+
+        for (size_t m = 0; m < mode_count; m++) {
+            if (strcmp(mode, "all") != 0
+                    && strcmp(mode, MODES[m].name) != 0) {
+                continue;
+            }
+
+            lseek(fd, 0, SEEK_SET);
+            uint32_t crc;
+            double t = now();
+            int err = MODES[m].checksum(fd, st.st_size, &crc);
+            t = now() - t;
+            if (err) {
+                fprintf(stderr, "%s: %s\n", argv[i], strerror(-err));
+                ret = 1;
+                continue;
+            }
+            times[m] += t;
+            totals[m] += st.st_size;
+
+            printf("%08"PRIx32" %-6s %10jd %9.3f  %s\n",
+                    crc, MODES[m].name, (intmax_t)st.st_size,
+                    (t > 0) ? st.st_size / t / 1e9 : 0.0,
+                    argv[i]);
+        }
+
+        close(fd);
+    }
+
+    // totals, note the first mode to touch a file pays for the page cache
+    if (argc - optind > 1) {
+        for (size_t m = 0; m < mode_count; m++) {
+            if (times[m] > 0) {
+                printf("%-8s %-6s %10"PRIu64" %9.3f  (total, %s)\n",
+                        "", MODES[m].name, totals[m],
+                        totals[m] / times[m] / 1e9, crc32c_name);
+            }
+        }
+    }
+
+    return ret;
+}
@@ -36,9 +36,52 @@ def prem(a, b):
             return a
         a ^= b << (a_bits-b_bits)
 
+# constants for narrower crcs, crc16/crc8, these fold width-bit elements
+# with vmull.p16/vmull.p8, so there's only one fold constant
+def main_narrow(polynomial, width):
+    def show(name, x):
+        print('%-12s = %11s [0x%0*x | 0x%0*x]' % (
+            name,
+            '0x%x' % x,
+            width//4, w(x, width),
+            width//4, brev(x, width)))
+
+    polynomial_r = brev(polynomial >> 1, width)
+    show('polynomial', polynomial)
+    show('polynomial_r', polynomial_r)
+
+    barret = pdiv(1 << (2*width), polynomial)
+    barret_r = brev(barret >> 1, width)
+    show('barret', barret)
+    show('barret_r', barret_r)
+
+    # each element is multiplied by a width-bit constant, with the result
+    # landing in a 2*width-bit lane, the even elements land in place, the
+    # odd elements need to be shifted up by width-bits
+    #
+    # [ 8 | 8 | 8 | 8 | 8 | 8 | 8 | 8 |       128       ]
+    #   |   |   |   |   |   |   |   |          +
+    #   |   '---|---+---|---+---|---+--->[ 16 | 16 ...  ] << 8
+    #   |       |       |       |              +
+    #   '-------+-------+-------+------->[ 16 | 16 ...  ]
+    #
+    #                                    '-------.-------'
+    #                                           128
+    #                                   '--------.--------'
+    #                                        128+width
+
+    k_r = brev(prem(1 << (128+width-1), polynomial), width)
+    show('k%d_r' % (128+width), k_r)
+
 # entry point
-def main():
-    polynomial = 0x11edc6f41
+def main(polynomial=0x11edc6f41, width=32, windows=[], stripes=[]):
+    if polynomial.bit_length()-1 != width:
+        print('polynomial 0x%x should include the x^%d term'
+            % (polynomial, width))
+        return 1
+    if width != 32:
+        return main_narrow(polynomial, width)
+
     polynomial_r = brev(polynomial >> 1)
     print('%-12s = %11s [0x%08x | 0x%08x]' % (
         'polynomial',
@@ -64,6 +107,15 @@ def main():
         w(barret_r),
         brev(barret_r)))
 
+    # both of these are already bit-reflected, so Barret reduction can stay
+    # in the reflected domain, no rbit needed, the ^ b provides the x^32
+    # term that doesn't fit in polynomial_r:
+    #
+    #   b   = lo32(crc * barret_r)
+    #   crc = hi32(b * polynomial_r) ^ b
+    #
+    # for bytes, crc << 24 and (crc >> 8) ^ ...
+
     # [ 32  | 32  |    64     ]
     #    |     |        +
     #    |     '->[    64     ]
@@ -207,5 +259,138 @@ def main():
         w(k8224_r),
         brev(k8224_r)))
 
+    # long folds for merging 3 streams over equal stripes, each 16-bit
+    # half needs its own constant, and the 16-bit overflow, which is
+    # already 128-bits ahead, needs a fold 128-bits shorter
+    #
+    # [    stripe    |    stripe     |    stripe     ]
+    #          |              |              +
+    #          |              '------------->[ 128 ]
+    #          |                             +
+    #          '---------------------------->[ 128 ]
+    #
+    # k_lower = k(n+16)[15:0] << 16 | k(n+32)[15:0]
+    # k_upper = k(n+16)[31:16] << 16 | k(n+32)[31:16]
+    #
+    # the stripe size depends on the message, so the kernel finds these
+    # at runtime, k(n-112) with crc32c_xpow, times x^16, x^128, x^144
+
+    for x in [16, 128, 144]:
+        x_r = brev(prem(1 << x, polynomial))
+        print('%-12s = %11s [0x%08x | 0x%08x]' % (
+            'x%d_r' % x,
+            '0x%x' % x_r,
+            w(x_r),
+            brev(x_r)))
+
+    for stripe in stripes:
+        for n in [8*stripe, 16*stripe]:
+            for m in [n-112, n-96, n+16, n+32]:
+                k_r = brev(prem(1 << (m-1), polynomial))
+                print('%-12s = %11s [0x%08x | 0x%08x]' % (
+                    'k%d_r' % m,
+                    '0x%x' % k_r,
+                    w(k_r),
+                    brev(k_r)))
+
+    # shifting a crc32c back out over n zero bytes, the pipeline pads short
+    # tails with zeros and undoes them with a multiply by x^-8n, x^-1 is
+    # just (P-1)/x since P has an x^0 term
+    #
+    # [ 32  |   8*n zeros   ]
+    #    |
+    #    '-> * x^(-8n-1)
+
+    xinv = polynomial >> 1
+    xneg = 1
+    for n in range(1, 17):
+        for _ in range(8):
+            xneg = prem(pmul(xneg, xinv), polynomial)
+        k_r = brev(prem(pmul(xneg, xinv), polynomial))
+        print('%-12s = %11s [0x%08x | 0x%08x]' % (
+            'k-%d_r' % (8*n),
+            '0x%x' % k_r,
+            w(k_r),
+            brev(k_r)))
+
+    # rolling crc32c constants, the outgoing byte table is
+    # crc(b) * x^(8*window) mod P, and crc32c(zeros) converts the rolling
+    # crc into a real crc32c
+    #
+    # [ out |        window        | in  ]
+    #    |                            +
+    #    '--------------------------->[ 32  ]
+    #
+    #       '----------.-----------'
+    #              8*window
+
+    for window in windows:
+        kw_r = brev(prem(1 << (8*window), polynomial))
+        print('%-12s = %11s [0x%08x | 0x%08x]' % (
+            'k%d_r' % (8*window),
+            '0x%x' % kw_r,
+            w(kw_r),
+            brev(kw_r)))
+        zeros = w(brev(prem(0xffffffff << (8*window), polynomial))
+            ^ 0xffffffff)
+        print('%-12s = %11s [0x%08x | 0x%08x]' % (
+            'zeros%d' % window,
+            '0x%x' % zeros,
+            w(zeros),
+            brev(zeros)))
+
+# slicing-by-4 tables for crc32c_table_gather_32wide, printed as a C
+# initializer, slice 3 is crc32c_table's TABLE, and each slice before it
+# shifts by one more byte:
+#
+#   TABLE[3][n] = crc32c_table's TABLE[n]
+#   TABLE[k][n] = (TABLE[k+1][n] >> 8) ^ TABLE[3][TABLE[k+1][n] & 0xff]
+def main_table(polynomial):
+    polynomial_r = brev(w(polynomial))
+    table = []
+    for n in range(256):
+        crc = n
+        for _ in range(8):
+            crc = (crc >> 1) ^ (polynomial_r if crc & 1 else 0)
+        table.append(crc)
+
+    slices = [table]
+    for _ in range(3):
+        slices.insert(0, [(x >> 8) ^ table[x & 0xff] for x in slices[0]])
+
+    print('static const uint32_t TABLE[4][256] = {')
+    for slice in slices:
+        print('    {')
+        for i in range(0, 256, 4):
+            print('        %s,' % ', '.join(
+                '0x%08x' % x for x in slice[i:i+4]))
+        print('    },')
+    print('};')
+
 if __name__ == "__main__":
-    main()
+    import argparse
+    import sys
+    parser = argparse.ArgumentParser(
+        description="Print constants for crc32c kernels.")
+    parser.add_argument('-p', '--polynomial', type=lambda x: int(x, 0),
+        default=0x11edc6f41,
+        help="Polynomial, including the x^width term. Defaults to "
+            "crc32c's 0x11edc6f41, crc32 is 0x104c11db7.")
+    parser.add_argument('-W', '--width', type=int, default=32,
+        help="Width of the crc in bits, 8 or 16 print the constants for the "
+            "crc8/crc16 kernels. Defaults to 32.")
+    parser.add_argument('-w', '--window', dest='windows', type=int,
+        action='append', default=[],
+        help="Also print rolling crc32c constants for this window size in "
+            "bytes, can be repeated.")
+    parser.add_argument('-s', '--stripe', dest='stripes', type=int,
+        action='append', default=[],
+        help="Also print 3-stream merge constants for this stripe size in "
+            "bytes, can be repeated.")
+    parser.add_argument('-t', '--table', action='store_true',
+        help="Print the slicing-by-4 tables for "
+            "crc32c_table_gather_32wide instead.")
+    args = vars(parser.parse_args())
+    if args.pop('table'):
+        sys.exit(main_table(args['polynomial']))
+    sys.exit(main(**args))
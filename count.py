@@ -8,7 +8,8 @@ TYPES = {
     'mul': '(mul.*|umull)',
     'ld/st': '(push|pop|ldr.*|str.*|ldmia.*|stmdb.*|vpush|vpop|vldr.*'
         '|vrev.*|vstr.*|vsli.*|vshr.*|vddup.*)',
-    'branch': '(bne.*|bcc.*|bhi.*|beq.*|bcs.*|le|cbz|cbnz)',
+    'branch': '(bne.*|bcc.*|bhi.*|beq.*|bcs.*|letp|le|wlstp.*|dlstp.*'
+        '|cbz|cbnz)',
     'other': '(and.*|orr.*|eor.*|add.*|sub.*|mov.*|mvn.*|lsl.*|lsr.*'
         '|uxtb|uxth|it|cmp|bic.*|rbit|b\.n|b\.w|bl|bx|dls|tst|vmsr|vpst'
         '|rsb|ubfx)',
@@ -0,0 +1,117 @@
+// CRC-16 implementations using polynomial folding leveraging ARMv8-M's MVE
+// vmull.p16 instruction, 8 16-bit halfwords at a time
+//
+// This is the same fold as crc32c_folding_vmullp16_8x16wide, except a
+// 16-bit crc only needs a single 16-bit constant per halfword. vmullb
+// folds the even halfwords, which land in place, and vmullt folds the odd
+// halfwords, which need to be shifted up by 16-bits with vshlc.
+//
+// Provides CRC-16/ARC (IBM, 0x8005) and CRC-16/KERMIT (CCITT, 0x1021),
+// both bit-reflected, with no init/final xor, so crcs can be chained.
+// Constants come from ./constants.py -W 16 -p <polynomial>.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <arm_mve.h>
+
+
+static inline uint32_t pmul16(uint16_t a, uint16_t b) {
+    uint32x4_t x_v = __arm_vmullbq_poly_p16(
+            __arm_vdupq_n_u16(a), __arm_vdupq_n_u16(b));
+    return __arm_vgetq_lane_u32(x_v, 0);
+}
+
+static inline uint16_t reduce8(uint16_t crc, uint8_t d,
+        uint16_t barret, uint16_t polynomial) {
+    // Barret reduce 8-bit bytes
+    crc = crc ^ d;
+    uint16_t b = pmul16(crc << 8, barret);
+    return (crc >> 8) ^ (pmul16(b, polynomial) >> 16) ^ b;
+}
+
+static inline uint16_t reduce16(uint16_t crc, uint16_t d,
+        uint16_t barret, uint16_t polynomial) {
+    // Barret reduce 16-bit halfwords
+    crc = crc ^ d;
+    uint16_t b = pmul16(crc, barret);
+    return (pmul16(b, polynomial) >> 16) ^ b;
+}
+
+static inline uint16x8_t fold128(
+        uint16x8_t folded_v, uint32_t *overflow, uint16x8_t k_v) {
+    // p16xp16 -> p32 folds
+    uint32x4_t lower_v = __arm_vmullbq_poly_p16(folded_v, k_v);
+    uint32x4_t upper_v = __arm_vmulltq_poly_p16(folded_v, k_v);
+    // xor/shift into folded
+    return (uint16x8_t)__arm_veorq_u32(lower_v,
+            __arm_vshlcq_u32(upper_v, overflow, 16));
+}
+
+static inline uint16_t crc16_folding(
+        uint16_t crc, const void *data, size_t size,
+        uint16_t k, uint16_t barret, uint16_t polynomial) {
+    const uint8_t *data_ = data;
+
+    // bytes/halfwords until aligned
+    size_t i = 0;
+    for (; i < size && ((uintptr_t)&data_[i]) % 2 != 0; i++) {
+        crc = reduce8(crc, data_[i], barret, polynomial);
+    }
+    for (; i+2 <= size && ((uintptr_t)&data_[i]) % 16 != 0; i += 2) {
+        crc = reduce16(crc, *(const uint16_t*)&data_[i],
+                barret, polynomial);
+    }
+
+    // aligned folds, leaving the last 128-bits for the tail to reduce
+    if (i+16+16 <= size) {
+        uint16x8_t k_v = __arm_vdupq_n_u16(k);
+        uint16x8_t folded_v = (uint16x8_t)__arm_vsetq_lane_u32(
+                crc, __arm_vdupq_n_u32(0), 0);
+        uint32_t overflow = 0;
+
+        const uint16_t *blocks = (const uint16_t*)&data_[i];
+        size_t count = (size-16 - i) / 16;
+        for (size_t j = 0; j < count; j++) {
+            folded_v = fold128(
+                    __arm_veorq_u16(folded_v, __arm_vld1q_u16(&blocks[8*j])),
+                    &overflow, k_v);
+        }
+        i += 16*count;
+
+        // reduce our folded state with the last 128-bits, the overflow
+        // is 128-bits ahead, which is where our crc is
+        uint16_t folded[8];
+        __arm_vst1q_u16(folded, folded_v);
+        crc = 0;
+        for (size_t j = 0; j < 8; j++, i += 2) {
+            crc = reduce16(crc,
+                    *(const uint16_t*)&data_[i] ^ folded[j],
+                    barret, polynomial);
+        }
+        crc ^= overflow;
+    }
+
+    // trailing halfwords/bytes
+    for (; i+2 <= size; i += 2) {
+        crc = reduce16(crc, *(const uint16_t*)&data_[i],
+                barret, polynomial);
+    }
+    for (; i < size; i++) {
+        crc = reduce8(crc, data_[i], barret, polynomial);
+    }
+
+    return crc;
+}
+
+uint16_t crc16_arc_folding_vmullp16(
+        uint16_t crc, const void *data, size_t size) {
+    // fold by 128 bits, k144
+    return crc16_folding(crc, data, size, 0x90c1, 0xbfff, 0x4003);
+}
+
+uint16_t crc16_kermit_folding_vmullp16(
+        uint16_t crc, const void *data, size_t size) {
+    // fold by 128 bits, k144
+    return crc16_folding(crc, data, size, 0x8e10, 0x1911, 0x0811);
+}
@@ -30,25 +30,44 @@ static inline uint32_t pmul32(uint32_t a, uint32_t b) {
          ^ (0x88888888 & ((a0*b3) ^ (a1*b2) ^ (a2*b1) ^ (a3*b0)));
 }
 
+static inline uint32_t reduce8(uint32_t crc, uint8_t d) {
+    crc = crc ^ d;
+    crc = (crc >> 8) ^ rbit32(pmul32(
+            rbit32(pmul32(crc << 24, 0xdea713f1)),
+            0x1edc6f41));
+    return crc;
+}
+
+static inline uint32_t reduce32(uint32_t crc, uint32_t d) {
+    crc = crc ^ d;
+    crc = rbit32(pmul32(
+            rbit32(pmul32(crc, 0xdea713f1)),
+            0x1edc6f41));
+    return crc;
+}
+
 uint32_t crc32c_barret_sparse_unrolled_32wide(
         uint32_t crc, const void *data, size_t size) {
     const uint8_t *data_ = data;
     crc = crc ^ 0xffffffff;
 
-    for (size_t i = 0; i < size;) {
-        if (((uintptr_t)&data_[i]) % 4 == 0 && i+4 <= size) {
-            crc = crc ^ *(const uint32_t*)&data_[i];
-            crc = rbit32(pmul32(
-                    rbit32(pmul32(crc, 0xdea713f1)),
-                    0x1edc6f41));
-            i += 4;
-        } else {
-            crc = crc ^ data_[i];
-            crc = (crc >> 8) ^ rbit32(pmul32(
-                    rbit32(pmul32(crc << 24, 0xdea713f1)),
-                    0x1edc6f41));
-            i += 1;
-        }
+    // bytes until aligned
+    size_t i = 0;
+    for (; i < size && ((uintptr_t)&data_[i]) % 4 != 0; i++) {
+        crc = reduce8(crc, data_[i]);
+    }
+
+    // aligned words
+    const uint32_t *words = (const uint32_t*)&data_[i];
+    size_t count = (size - i) / 4;
+    for (size_t j = 0; j < count; j++) {
+        crc = reduce32(crc, words[j]);
+    }
+    i += 4*count;
+
+    // trailing bytes
+    for (; i < size; i++) {
+        crc = reduce8(crc, data_[i]);
     }
 
     return crc ^ 0xffffffff;
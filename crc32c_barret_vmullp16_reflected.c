@@ -0,0 +1,51 @@
+// A crc32c implementation using Barret reduction leveraging ARMv8-M's MVE
+// vmull.p16 instruction, staying in the bit-reflected domain to avoid
+// rbit round trips
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <arm_mve.h>
+
+
+static inline uint32_t pmul32(uint32_t a, uint32_t b) {
+    uint16x8_t a_v = __arm_vdupq_n_u16(a);
+    uint16x8_t b_v = __arm_vdupq_n_u16(b);
+    a_v = (uint16x8_t)__arm_vsetq_lane_u32(a, (uint32x4_t)a_v, 1);
+    b_v = (uint16x8_t)__arm_vsetq_lane_u32(b, (uint32x4_t)b_v, 2);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(a_v, b_v);
+
+    return __arm_vgetq_lane_u32(x_v, 0)
+            ^ (__arm_vgetq_lane_u32(x_v, 1) << 16)
+            ^ (__arm_vgetq_lane_u32(x_v, 2) << 16);
+}
+
+// upper 32-bits of a 32x32 pmul, hi*hi ^ (hi*lo ^ lo*hi) >> 16
+static inline uint32_t pmul32_hi(uint32_t a, uint32_t b) {
+    uint32x4_t a_v = __arm_vdupq_n_u32(a);
+    uint32x4_t b_v = __arm_vdupq_n_u32(b);
+    a_v = __arm_vsetq_lane_u32(a << 16, a_v, 2);
+    b_v = __arm_vsetq_lane_u32(b << 16, b_v, 1);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)a_v, (uint16x8_t)b_v);
+
+    return __arm_vgetq_lane_u32(x_v, 0)
+            ^ (__arm_vgetq_lane_u32(x_v, 1) >> 16)
+            ^ (__arm_vgetq_lane_u32(x_v, 2) >> 16);
+}
+
+uint32_t crc32c_barret_vmullp16_reflected(
+        uint32_t crc, const void *data, size_t size) {
+    const uint8_t *data_ = data;
+    crc = crc ^ 0xffffffff;
+
+    for (size_t i = 0; i < size; i++) {
+        crc = crc ^ data_[i];
+        uint32_t b = pmul32(crc << 24, 0xdea713f1);
+        crc = (crc >> 8) ^ pmul32_hi(b, 0x05ec76f1) ^ b;
+    }
+
+    return crc ^ 0xffffffff;
+}
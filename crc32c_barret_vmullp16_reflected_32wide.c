@@ -0,0 +1,76 @@
+// A crc32c implementation using Barret reduction leveraging ARMv8-M's MVE
+// vmull.p16 instruction, staying in the bit-reflected domain to avoid
+// rbit round trips, a word at a time
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <arm_mve.h>
+
+
+static inline uint32_t pmul32(uint32_t a, uint32_t b) {
+    uint16x8_t a_v = __arm_vdupq_n_u16(a);
+    uint16x8_t b_v = __arm_vdupq_n_u16(b);
+    a_v = (uint16x8_t)__arm_vsetq_lane_u32(a, (uint32x4_t)a_v, 1);
+    b_v = (uint16x8_t)__arm_vsetq_lane_u32(b, (uint32x4_t)b_v, 2);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(a_v, b_v);
+
+    return __arm_vgetq_lane_u32(x_v, 0)
+            ^ (__arm_vgetq_lane_u32(x_v, 1) << 16)
+            ^ (__arm_vgetq_lane_u32(x_v, 2) << 16);
+}
+
+// upper 32-bits of a 32x32 pmul, hi*hi ^ (hi*lo ^ lo*hi) >> 16
+static inline uint32_t pmul32_hi(uint32_t a, uint32_t b) {
+    uint32x4_t a_v = __arm_vdupq_n_u32(a);
+    uint32x4_t b_v = __arm_vdupq_n_u32(b);
+    a_v = __arm_vsetq_lane_u32(a << 16, a_v, 2);
+    b_v = __arm_vsetq_lane_u32(b << 16, b_v, 1);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)a_v, (uint16x8_t)b_v);
+
+    return __arm_vgetq_lane_u32(x_v, 0)
+            ^ (__arm_vgetq_lane_u32(x_v, 1) >> 16)
+            ^ (__arm_vgetq_lane_u32(x_v, 2) >> 16);
+}
+
+static inline uint32_t reduce8(uint32_t crc, uint8_t d) {
+    crc = crc ^ d;
+    uint32_t b = pmul32(crc << 24, 0xdea713f1);
+    return (crc >> 8) ^ pmul32_hi(b, 0x05ec76f1) ^ b;
+}
+
+static inline uint32_t reduce32(uint32_t crc, uint32_t d) {
+    crc = crc ^ d;
+    uint32_t b = pmul32(crc, 0xdea713f1);
+    return pmul32_hi(b, 0x05ec76f1) ^ b;
+}
+
+uint32_t crc32c_barret_vmullp16_reflected_32wide(
+        uint32_t crc, const void *data, size_t size) {
+    const uint8_t *data_ = data;
+    crc = crc ^ 0xffffffff;
+
+    // bytes until aligned
+    size_t i = 0;
+    for (; i < size && ((uintptr_t)&data_[i]) % 4 != 0; i++) {
+        crc = reduce8(crc, data_[i]);
+    }
+
+    // aligned words
+    const uint32_t *words = (const uint32_t*)&data_[i];
+    size_t count = (size - i) / 4;
+    for (size_t j = 0; j < count; j++) {
+        crc = reduce32(crc, words[j]);
+    }
+    i += 4*count;
+
+    // trailing bytes
+    for (; i < size; i++) {
+        crc = reduce8(crc, data_[i]);
+    }
+
+    return crc ^ 0xffffffff;
+}
@@ -1,5 +1,8 @@
 // A crc32c implementation using a bitsliced polynomial multiplication
 // to fold 64 pairs of 32-bit words (512 bytes) at a time
+//
+// Generated by bitsliced.py, 64 slices stored in 1 64-bit
+// word(s) per bit
 
 #include <stdint.h>
 #include <stddef.h>
@@ -8,16 +11,6 @@
 #include <arm_mve.h>
 
 
-static inline uint32_t rbit32(uint32_t a) {
-    uint32_t x;
-    __asm__(
-        "rbit %0,%1"
-        : "=r"(x)
-        : "r"(a)
-    );
-    return x;
-}
-
 static inline uint64_t pmul32(uint32_t a, uint32_t b) {
     uint16x8_t a_v = __arm_vdupq_n_u16(a);
     uint16x8_t b_v = __arm_vdupq_n_u16(b);
@@ -34,125 +27,169 @@ static inline uint64_t pmul32(uint32_t a, uint32_t b) {
          ^ ((uint64_t)__arm_vgetq_lane_u32(x_v, 3) << 32);
 }
 
+// words per row of bits
+#define WORDS 1
+
 static inline void bitsliced_xorpmul64x64(
-        uint64_t d[static restrict 64],
-        const uint64_t a[static restrict 32],
+        uint64_t d[static restrict 64*WORDS],
+        const uint64_t a[static restrict 32*WORDS],
         uint32_t k) {
     for (size_t i = 0; i < 32; i++) {
         if (k & (1 << i)) {
-            for (size_t j = 0; j < 32; j++) {
-                d[j+i] ^= a[j];
+            for (size_t j = 0; j < 32*WORDS; j++) {
+                d[j+i*WORDS] ^= a[j];
             }
         }
     }
 }
 
 static inline void bitsliced_zero64x64(
-        uint64_t d[static restrict 64]) {
-    memset(d, 0, 64*sizeof(uint64_t));
+        uint64_t d[static restrict 64*WORDS]) {
+    memset(d, 0, 64*WORDS*sizeof(uint64_t));
 }
 
 static inline uint32_t bitsliced_get32(
-        const uint64_t d[static restrict 64]) {
+        const uint64_t d[static restrict 32*WORDS]) {
     uint32_t r = 0;
     for (size_t j = 0; j < 32; j++) {
-        r |= (d[j] & 1) << j;
+        r |= (uint32_t)(d[j*WORDS] & 1) << j;
     }
     return r;
 }
 
 static inline void bitsliced_set32(
-        uint64_t d[static restrict 64],
+        uint64_t d[static restrict 64*WORDS],
         uint32_t r) {
     for (size_t j = 0; j < 32; j++) {
-         d[j] = (r >> j) & 1;
+         d[j*WORDS] = (r >> j) & 1;
     }
 }
 
 static inline void bitsliced_xorload64x64(
-        uint64_t d[static restrict 64],
+        uint64_t d[static restrict 64*WORDS],
         const uint64_t s[static restrict 64]) {
     const uint32_t *restrict s_ = (const uint32_t *restrict)s;
     for (size_t j = 0; j < 64; j++) {
-        uint64_t r = d[j];
-        for (size_t i = 0; i < 64; i++) {
-             r ^= (uint64_t)((s_[2*i+(j/32)] >> (j%32)) & 1) << i;
+        for (size_t w = 0; w < WORDS; w++) {
+            uint64_t r = d[j*WORDS+w];
+            for (size_t i = 0; i < 64; i++) {
+                r ^= (uint64_t)((s_[2*(64*w+i)+(j/32)] >> (j%32)) & 1) << i;
+            }
+            d[j*WORDS+w] = r;
         }
-        d[j] = r;
     }
 }
 
 static inline void bitsliced_xorshr64(
-        uint64_t d[static restrict 64],
+        uint64_t d[static restrict 64*WORDS],
         uint64_t r) {
     for (size_t j = 0; j < 64; j++) {
-        d[j] = (d[j] >> 1) ^ ((r >> j) & 1);
+        for (size_t w = 0; w < WORDS-1; w++) {
+            d[j*WORDS+w] = (d[j*WORDS+w] >> 1)
+                    | (d[j*WORDS+w+1] << (64-1));
+        }
+        d[j*WORDS+WORDS-1] >>= 1;
+        d[j*WORDS] ^= (r >> j) & 1;
     }
 }
 
 static inline void bitsliced_xorshr32(
-        uint64_t d[static restrict 64],
+        uint64_t d[static restrict 64*WORDS],
         uint32_t r) {
     for (size_t j = 0; j < 32; j++) {
-        d[j] = d[j+32] ^ ((r >> j) & 1);
+        for (size_t w = 0; w < WORDS; w++) {
+            d[j*WORDS+w] = d[(j+32)*WORDS+w];
+        }
+        d[j*WORDS] ^= (r >> j) & 1;
     }
 
-    memset(&d[32], 0, 32*sizeof(uint64_t));
+    memset(&d[32*WORDS], 0, 32*WORDS*sizeof(uint64_t));
+}
+
+static inline void bitsliced_fold64(
+        uint64_t d[static restrict 64*WORDS],
+        uint64_t r) {
+    uint64_t folded
+            = pmul32(
+                bitsliced_get32(&d[0]) ^ (uint32_t)r,
+                0x493c7d27)
+            ^ pmul32(
+                bitsliced_get32(&d[32*WORDS]) ^ (uint32_t)(r >> 32),
+                0xdd45aab8);
+    bitsliced_xorshr64(d, folded);
+}
+
+static inline void bitsliced_reduce32(
+        uint64_t d[static restrict 64*WORDS],
+        uint32_t r) {
+    uint32_t crc = bitsliced_get32(d) ^ r;
+    uint32_t b = (uint32_t)pmul32(crc, 0xdea713f1);
+    bitsliced_xorshr32(d,
+            (uint32_t)(pmul32(b, 0x05ec76f1) >> 32)
+            ^ b);
 }
 
+static inline void bitsliced_reduce8(
+        uint64_t d[static restrict 64*WORDS],
+        uint8_t r) {
+    uint32_t crc = bitsliced_get32(d) ^ r;
+    uint32_t b = (uint32_t)pmul32(crc << 24, 0xdea713f1);
+    bitsliced_set32(d, (crc >> 8)
+            ^ (uint32_t)(pmul32(b, 0x05ec76f1) >> 32)
+            ^ b);
+}
 
 uint32_t crc32c_bitsliced_64x2x32wide(
         uint32_t crc, const void *data, size_t size) {
     const uint8_t *data_ = data;
 
     // two buffers to alternate between
-    uint64_t slices[2][64] = {{0}, {0}};
+    uint64_t slices[2][64*WORDS] = {{0}, {0}};
     bool flip = false;
 
     bitsliced_set32(slices[flip], crc ^ 0xffffffff);
 
-    for (size_t i = 0; i < size;) {
-        if (((uintptr_t)&data_[i]) % 512 == 0 && i+512+512 <= size) {
+    // bytes/words/64-bit folds until aligned
+    size_t i = 0;
+    for (; i < size && ((uintptr_t)&data_[i]) % 4 != 0; i++) {
+        bitsliced_reduce8(slices[flip], data_[i]);
+    }
+    for (; i+4 <= size && ((uintptr_t)&data_[i]) % 8 != 0; i += 4) {
+        bitsliced_reduce32(slices[flip], *(const uint32_t*)&data_[i]);
+    }
+    for (; i+8+8 <= size && ((uintptr_t)&data_[i]) % 512 != 0; i += 8) {
+        bitsliced_fold64(slices[flip], *(const uint64_t*)&data_[i]);
+    }
+
+    // aligned bitsliced folds, leaving the last 512 bytes for the tail
+    // to reduce
+    if (i+512+512 <= size) {
+        const uint64_t *blocks = (const uint64_t*)&data_[i];
+        size_t count = (size-512 - i) / 512;
+        for (size_t j = 0; j < count; j++) {
             // xor data into folded
-            bitsliced_xorload64x64(slices[flip], (const uint64_t*)&data_[i]);
+            bitsliced_xorload64x64(slices[flip], &blocks[64*j]);
             // fold with 2 32x32 pmuls, note these already xor
             bitsliced_zero64x64(slices[!flip]);
             bitsliced_xorpmul64x64(slices[!flip],
                     &slices[flip][ 0], 0xbd6f81f8);
             bitsliced_xorpmul64x64(slices[!flip],
-                    &slices[flip][32], 0xe986c148);
+                    &slices[flip][32*WORDS], 0xe986c148);
             flip = !flip;
-            i += 512;
-        } else if (((uintptr_t)&data_[i]) % 8 == 0 && i+8+8 <= size) {
-            uint64_t folded
-                    = pmul32(
-                        bitsliced_get32(&slices[flip][0])
-                            ^ *(const uint32_t*)&data_[i+0],
-                        0x493c7d27)
-                    ^ pmul32(
-                        bitsliced_get32(&slices[flip][32])
-                            ^ *(const uint32_t*)&data_[i+4],
-                        0xdd45aab8);
-            bitsliced_xorshr64(slices[flip], folded);
-            i += 8;
-        } else if (((uintptr_t)&data_[i]) % 4 == 0 && i+4 <= size) {
-            crc = bitsliced_get32(slices[flip])
-                    ^ *(const uint32_t *)&data_[i];
-            uint32_t b = (uint32_t)pmul32(crc, 0xdea713f1);
-            bitsliced_xorshr32(slices[flip],
-                    (uint32_t)(pmul32(b, 0x05ec76f1) >> 32)
-                    ^ b);
-            i += 4;
-        } else {
-            crc = bitsliced_get32(slices[flip]) ^ data_[i];
-            uint32_t b = (uint32_t)pmul32(crc << 24, 0xdea713f1);
-            bitsliced_set32(slices[flip], (crc >> 8)
-                    ^ (uint32_t)(pmul32(b, 0x05ec76f1) >> 32)
-                    ^ b);
-            i += 1;
         }
+        i += 512*count;
+    }
+
+    // trailing 64-bit folds/words/bytes
+    for (; i+8+8 <= size; i += 8) {
+        bitsliced_fold64(slices[flip], *(const uint64_t*)&data_[i]);
+    }
+    for (; i+4 <= size; i += 4) {
+        bitsliced_reduce32(slices[flip], *(const uint32_t*)&data_[i]);
+    }
+    for (; i < size; i++) {
+        bitsliced_reduce8(slices[flip], data_[i]);
     }
 
     return bitsliced_get32(slices[flip]) ^ 0xffffffff;
 }
-
@@ -0,0 +1,173 @@
+// A crc32c+crc32 implementation using polynomial folding leveraging
+// ARMv8-M's MVE vmull.p16 instruction, 8 16-bit halfwords at a time
+//
+// This computes both the crc32c (0x1edc6f41) and the legacy crc32
+// (0x04c11db7) in a single pass, loading each 16-byte block once and
+// folding it into two accumulators with two sets of constants. The
+// generic entry point only returns the crc32c, use crc32_crc32c for both.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <arm_mve.h>
+
+
+static inline uint32_t pmul32(uint32_t a, uint32_t b) {
+    uint16x8_t a_v = __arm_vdupq_n_u16(a);
+    uint16x8_t b_v = __arm_vdupq_n_u16(b);
+    a_v = (uint16x8_t)__arm_vsetq_lane_u32(a, (uint32x4_t)a_v, 1);
+    b_v = (uint16x8_t)__arm_vsetq_lane_u32(b, (uint32x4_t)b_v, 2);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(a_v, b_v);
+
+    return __arm_vgetq_lane_u32(x_v, 0)
+            ^ (__arm_vgetq_lane_u32(x_v, 1) << 16)
+            ^ (__arm_vgetq_lane_u32(x_v, 2) << 16);
+}
+
+// upper 32-bits of a 32x32 pmul, hi*hi ^ (hi*lo ^ lo*hi) >> 16
+static inline uint32_t pmul32_hi(uint32_t a, uint32_t b) {
+    uint32x4_t a_v = __arm_vdupq_n_u32(a);
+    uint32x4_t b_v = __arm_vdupq_n_u32(b);
+    a_v = __arm_vsetq_lane_u32(a << 16, a_v, 2);
+    b_v = __arm_vsetq_lane_u32(b << 16, b_v, 1);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)a_v, (uint16x8_t)b_v);
+
+    return __arm_vgetq_lane_u32(x_v, 0)
+            ^ (__arm_vgetq_lane_u32(x_v, 1) >> 16)
+            ^ (__arm_vgetq_lane_u32(x_v, 2) >> 16);
+}
+
+// constants for each polynomial, see constants.py
+#define CRC32C_K_LOWER    0x55460dfe
+#define CRC32C_K_UPPER    0x5407f20c
+#define CRC32C_BARRET     0xdea713f1
+#define CRC32C_POLYNOMIAL 0x05ec76f1
+
+#define CRC32_K_LOWER     0xe1769191
+#define CRC32_K_UPPER     0x9d0fae68
+#define CRC32_BARRET      0xf7011641
+#define CRC32_POLYNOMIAL  0xdb710641
+
+static inline uint32x4_t reduce8(uint32x4_t folded_v, uint8_t d,
+        uint32_t barret, uint32_t polynomial) {
+    // Barret reduce 8-bit bytes
+    uint32_t crc = __arm_vgetq_lane_u32(folded_v, 0) ^ d;
+    uint32_t b = pmul32(crc << 24, barret);
+    crc = (crc >> 8) ^ pmul32_hi(b, polynomial) ^ b;
+    return __arm_vsetq_lane_u32(crc, folded_v, 0);
+}
+
+static inline uint32x4_t reduce32(uint32x4_t folded_v, uint32_t *overflow,
+        uint32_t d, uint32_t barret, uint32_t polynomial) {
+    // Barret reduce 32-bit words
+    uint32_t crc = __arm_vgetq_lane_u32(folded_v, 0) ^ d;
+    uint32_t b = pmul32(crc, barret);
+    crc = __arm_vgetq_lane_u32(folded_v, 1) ^ pmul32_hi(b, polynomial) ^ b;
+    folded_v = __arm_vsetq_lane_u32(crc, folded_v, 0);
+    folded_v = __arm_vsetq_lane_u32(
+            __arm_vgetq_lane_u32(folded_v, 2), folded_v, 1);
+    folded_v = __arm_vsetq_lane_u32(
+            __arm_vgetq_lane_u32(folded_v, 3), folded_v, 2);
+    folded_v = __arm_vsetq_lane_u32(*overflow, folded_v, 3);
+    *overflow = 0;
+    return folded_v;
+}
+
+static inline uint32x4_t fold128(
+        uint32x4_t folded_v, uint32_t *overflow,
+        uint32x4_t k_lower_v, uint32x4_t k_upper_v,
+        uint32x4_t data_v) {
+    // xor data into folded
+    folded_v = __arm_veorq_u32(folded_v, data_v);
+    // 2x p16xp32 -> p48 folds
+    uint32x4_t lower0_v = __arm_vmullbq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_lower_v);
+    uint32x4_t lower1_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_lower_v);
+    uint32x4_t upper0_v = __arm_vmullbq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_upper_v);
+    uint32x4_t upper1_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_upper_v);
+    // xor/shift into folded
+    uint32x4_t lower_v = __arm_veorq_u32(lower0_v, lower1_v);
+    uint32x4_t upper_v = __arm_veorq_u32(upper0_v, upper1_v);
+    return __arm_veorq_u32(lower_v,
+            __arm_vshlcq_u32(upper_v, overflow, 16));
+}
+
+// noinline so the crc32 half isn't optimized out of the generic entry
+// point, which would make comparisons with other kernels meaningless
+__attribute__((noinline))
+void crc32_crc32c(uint32_t *crc32, uint32_t *crc32c,
+        const void *data, size_t size) {
+    const uint8_t *data_ = data;
+
+    uint32x4_t a_k_lower_v = __arm_vdupq_n_u32(CRC32C_K_LOWER);
+    uint32x4_t a_k_upper_v = __arm_vdupq_n_u32(CRC32C_K_UPPER);
+    uint32x4_t b_k_lower_v = __arm_vdupq_n_u32(CRC32_K_LOWER);
+    uint32x4_t b_k_upper_v = __arm_vdupq_n_u32(CRC32_K_UPPER);
+
+    uint32x4_t a_v = __arm_vsetq_lane_u32(
+            *crc32c ^ 0xffffffff, __arm_vdupq_n_u32(0), 0);
+    uint32x4_t b_v = __arm_vsetq_lane_u32(
+            *crc32 ^ 0xffffffff, __arm_vdupq_n_u32(0), 0);
+    uint32_t a_overflow = 0;
+    uint32_t b_overflow = 0;
+
+    // bytes/words until aligned
+    size_t i = 0;
+    for (; i < size && ((uintptr_t)&data_[i]) % 4 != 0; i++) {
+        a_v = reduce8(a_v, data_[i],
+                CRC32C_BARRET, CRC32C_POLYNOMIAL);
+        b_v = reduce8(b_v, data_[i],
+                CRC32_BARRET, CRC32_POLYNOMIAL);
+    }
+    for (; i+4 <= size && ((uintptr_t)&data_[i]) % 16 != 0; i += 4) {
+        uint32_t d = *(const uint32_t*)&data_[i];
+        a_v = reduce32(a_v, &a_overflow, d,
+                CRC32C_BARRET, CRC32C_POLYNOMIAL);
+        b_v = reduce32(b_v, &b_overflow, d,
+                CRC32_BARRET, CRC32_POLYNOMIAL);
+    }
+
+    // aligned folds, each block is loaded once and folded into both
+    // accumulators, leaving the last 128-bits for the tail to reduce
+    if (i+16+16 <= size) {
+        const uint32_t *blocks = (const uint32_t*)&data_[i];
+        size_t count = (size-16 - i) / 16;
+        for (size_t j = 0; j < count; j++) {
+            uint32x4_t d_v = __arm_vld1q_u32(&blocks[4*j]);
+            a_v = fold128(a_v, &a_overflow, a_k_lower_v, a_k_upper_v, d_v);
+            b_v = fold128(b_v, &b_overflow, b_k_lower_v, b_k_upper_v, d_v);
+        }
+        i += 16*count;
+    }
+
+    // trailing words/bytes
+    for (; i+4 <= size; i += 4) {
+        uint32_t d = *(const uint32_t*)&data_[i];
+        a_v = reduce32(a_v, &a_overflow, d,
+                CRC32C_BARRET, CRC32C_POLYNOMIAL);
+        b_v = reduce32(b_v, &b_overflow, d,
+                CRC32_BARRET, CRC32_POLYNOMIAL);
+    }
+    for (; i < size; i++) {
+        a_v = reduce8(a_v, data_[i],
+                CRC32C_BARRET, CRC32C_POLYNOMIAL);
+        b_v = reduce8(b_v, data_[i],
+                CRC32_BARRET, CRC32_POLYNOMIAL);
+    }
+
+    *crc32c = __arm_vgetq_lane_u32(a_v, 0) ^ 0xffffffff;
+    *crc32 = __arm_vgetq_lane_u32(b_v, 0) ^ 0xffffffff;
+}
+
+uint32_t crc32c_dual_folding_vmullp16_8x16wide(
+        uint32_t crc, const void *data, size_t size) {
+    uint32_t crc32 = 0;
+    crc32_crc32c(&crc32, &crc, data, size);
+    return crc;
+}
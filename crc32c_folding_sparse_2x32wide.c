@@ -27,33 +27,59 @@ static inline uint64_t pmul32(uint32_t a, uint32_t b) {
     return x;
 }
 
+static inline uint64_t reduce8(uint64_t folded, uint8_t d) {
+    uint32_t crc = (uint32_t)folded ^ d;
+    uint32_t b = (uint32_t)pmul32(crc << 24, 0xdea713f1);
+    return (folded >> 8)
+            ^ (uint32_t)(pmul32(b, 0x05ec76f1) >> 32)
+            ^ b;
+}
+
+static inline uint64_t reduce32(uint64_t folded, uint32_t d) {
+    uint32_t crc = (uint32_t)folded ^ d;
+    uint32_t b = (uint32_t)pmul32(crc, 0xdea713f1);
+    return (folded >> 32)
+            ^ (uint32_t)(pmul32(b, 0x05ec76f1) >> 32)
+            ^ b;
+}
+
+static inline uint64_t fold64(uint64_t folded, uint64_t d) {
+    d = folded ^ d;
+    return pmul32((uint32_t)d, 0x493c7d27)
+            ^ pmul32((uint32_t)(d >> 32), 0xdd45aab8);
+}
+
 uint32_t crc32c_folding_sparse_2x32wide(
         uint32_t crc, const void *data, size_t size) {
     const uint8_t *data_ = data;
     crc = crc ^ 0xffffffff;
     uint64_t folded = crc;
 
-    for (size_t i = 0; i < size;) {
-        if (((uintptr_t)&data_[i]) % 8 == 0 && i+8+8 <= size) {
-            uint64_t d = folded ^ *(const uint64_t*)&data_[i];
-            folded = pmul32((uint32_t)d, 0x493c7d27)
-                   ^ pmul32((uint32_t)(d >> 32), 0xdd45aab8);
-            i += 8;
-        } else if (((uintptr_t)&data_[i]) % 4 == 0 && i+4 <= size) {
-            crc = (uint32_t)folded ^ *(const uint32_t*)&data_[i];
-            uint32_t b = (uint32_t)pmul32(crc, 0xdea713f1);
-            folded = (folded >> 32)
-                    ^ (uint32_t)(pmul32(b, 0x05ec76f1) >> 32)
-                    ^ b;
-            i += 4;
-        } else {
-            crc = (uint32_t)folded ^ data_[i];
-            uint32_t b = (uint32_t)pmul32(crc << 24, 0xdea713f1);
-            folded = (folded >> 8)
-                    ^ (uint32_t)(pmul32(b, 0x05ec76f1) >> 32)
-                    ^ b;
-            i += 1;
+    // bytes/words until aligned
+    size_t i = 0;
+    for (; i < size && ((uintptr_t)&data_[i]) % 4 != 0; i++) {
+        folded = reduce8(folded, data_[i]);
+    }
+    for (; i+4 <= size && ((uintptr_t)&data_[i]) % 8 != 0; i += 4) {
+        folded = reduce32(folded, *(const uint32_t*)&data_[i]);
+    }
+
+    // aligned folds, leaving the last 64-bits for the tail to reduce
+    if (i+8+8 <= size) {
+        const uint64_t *blocks = (const uint64_t*)&data_[i];
+        size_t count = (size-8 - i) / 8;
+        for (size_t j = 0; j < count; j++) {
+            folded = fold64(folded, blocks[j]);
         }
+        i += 8*count;
+    }
+
+    // trailing words/bytes
+    for (; i+4 <= size; i += 4) {
+        folded = reduce32(folded, *(const uint32_t*)&data_[i]);
+    }
+    for (; i < size; i++) {
+        folded = reduce8(folded, data_[i]);
     }
 
     return (uint32_t)folded ^ 0xffffffff;
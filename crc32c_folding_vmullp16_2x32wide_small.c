@@ -0,0 +1,124 @@
+// A crc32c implementation using polynomial folding leveraging ARMv8-M's MVE
+// vmull.p16 instruction, optimized for latency on small (4-64 byte)
+// messages
+//
+// There is no alignment loop, words are loaded unaligned, and each 16-byte
+// fold is 4 independent pmuls, so the dependency chain is 1 pmul per 16
+// bytes. The tail is reduced with at most one 64-bit, one 32-bit, and one
+// 1-3 byte Barret reduction, instead of a loop.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <arm_mve.h>
+
+
+static inline uint64_t pmul32(uint32_t a, uint32_t b) {
+    uint16x8_t a_v = __arm_vdupq_n_u16(a);
+    uint16x8_t b_v = __arm_vdupq_n_u16(b);
+    a_v = (uint16x8_t)__arm_vsetq_lane_u32(a, (uint32x4_t)a_v, 1);
+    a_v = (uint16x8_t)__arm_vsetq_lane_u32(a, (uint32x4_t)a_v, 3);
+    b_v = (uint16x8_t)__arm_vsetq_lane_u32(b, (uint32x4_t)b_v, 2);
+    b_v = (uint16x8_t)__arm_vsetq_lane_u32(b, (uint32x4_t)b_v, 3);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(a_v, b_v);
+
+    return ((uint64_t)__arm_vgetq_lane_u32(x_v, 0))
+         ^ ((uint64_t)__arm_vgetq_lane_u32(x_v, 1) << 16)
+         ^ ((uint64_t)__arm_vgetq_lane_u32(x_v, 2) << 16)
+         ^ ((uint64_t)__arm_vgetq_lane_u32(x_v, 3) << 32);
+}
+
+// unaligned loads, these should compile to plain ldrs on the M55
+static inline uint32_t load32(const uint8_t *p) {
+    uint32_t x;
+    memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+static inline uint64_t load64(const uint8_t *p) {
+    uint64_t x;
+    memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+static inline uint32_t reduce32(uint32_t crc, uint32_t d) {
+    // Barret reduce 32-bit words
+    uint32_t b = (uint32_t)pmul32(crc ^ d, 0xdea713f1);
+    return (uint32_t)(pmul32(b, 0x05ec76f1) >> 32) ^ b;
+}
+
+static inline uint32_t reduce24(uint32_t crc, const uint8_t *d, size_t n) {
+    // Barret reduce 1-3 bytes in one step, this is the same as reduce8,
+    // just with a wider shift
+    uint32_t x = d[0];
+    if (n > 1) {
+        x |= (uint32_t)d[1] << 8;
+    }
+    if (n > 2) {
+        x |= (uint32_t)d[2] << 16;
+    }
+    crc = crc ^ x;
+    uint32_t b = (uint32_t)pmul32(crc << (32-8*n), 0xdea713f1);
+    return (crc >> 8*n)
+            ^ (uint32_t)(pmul32(b, 0x05ec76f1) >> 32)
+            ^ b;
+}
+
+static inline uint32_t reduce64(uint64_t folded) {
+    // fold the lower word onto the upper word, then Barret reduce
+    uint64_t x = pmul32((uint32_t)folded, 0xdd45aab8) ^ (folded >> 32);
+    return (uint32_t)(x >> 32) ^ reduce32((uint32_t)x, 0);
+}
+
+static inline uint64_t fold64(uint64_t folded, uint64_t d) {
+    return pmul32((uint32_t)folded, 0x493c7d27)
+            ^ pmul32((uint32_t)(folded >> 32), 0xdd45aab8)
+            ^ d;
+}
+
+static inline uint64_t fold128(uint64_t folded, uint64_t d0, uint64_t d1) {
+    // none of these pmuls depend on each other
+    return pmul32((uint32_t)folded, 0xf20c0dfe)
+            ^ pmul32((uint32_t)(folded >> 32), 0x3171d430)
+            ^ pmul32((uint32_t)d0, 0x493c7d27)
+            ^ pmul32((uint32_t)(d0 >> 32), 0xdd45aab8)
+            ^ d1;
+}
+
+uint32_t crc32c_folding_vmullp16_2x32wide_small(
+        uint32_t crc, const void *data, size_t size) {
+    const uint8_t *data_ = data;
+    crc = crc ^ 0xffffffff;
+
+    // note folded always has the next 64-bits of data already xored in
+    size_t i = 0;
+    if (size >= 8) {
+        uint64_t folded = crc ^ load64(&data_[0]);
+        i += 8;
+
+        for (; i+16 <= size; i += 16) {
+            folded = fold128(folded,
+                    load64(&data_[i+0]),
+                    load64(&data_[i+8]));
+        }
+        if (i+8 <= size) {
+            folded = fold64(folded, load64(&data_[i]));
+            i += 8;
+        }
+
+        crc = reduce64(folded);
+    }
+
+    // trailing word/bytes
+    if (i+4 <= size) {
+        crc = reduce32(crc, load32(&data_[i]));
+        i += 4;
+    }
+    if (i < size) {
+        crc = reduce24(crc, &data_[i], size-i);
+    }
+
+    return crc ^ 0xffffffff;
+}
@@ -0,0 +1,214 @@
+// A crc32c implementation using polynomial folding leveraging ARMv8-M's MVE
+// vmull.p16 instruction, 8 16-bit halfwords at a time, in 3 independent
+// streams over equal stripes, merged once with long-distance folds
+//
+// Each stream only depends on itself, so the 3 fold chains can overlap.
+// The merge constants depend on the stripe size, so they're computed with
+// crc32c_xpow, which is why stripes have a minimum size.
+
+#include "patch.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <arm_mve.h>
+
+
+// minimum stripe size, smaller stripes aren't worth computing the merge
+// constants for
+#define STRIPE_MIN 1024
+
+static inline uint32_t pmul32(uint32_t a, uint32_t b) {
+    uint16x8_t a_v = __arm_vdupq_n_u16(a);
+    uint16x8_t b_v = __arm_vdupq_n_u16(b);
+    a_v = (uint16x8_t)__arm_vsetq_lane_u32(a, (uint32x4_t)a_v, 1);
+    b_v = (uint16x8_t)__arm_vsetq_lane_u32(b, (uint32x4_t)b_v, 2);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(a_v, b_v);
+
+    return __arm_vgetq_lane_u32(x_v, 0)
+            ^ (__arm_vgetq_lane_u32(x_v, 1) << 16)
+            ^ (__arm_vgetq_lane_u32(x_v, 2) << 16);
+}
+
+// upper 32-bits of a 32x32 pmul, hi*hi ^ (hi*lo ^ lo*hi) >> 16
+static inline uint32_t pmul32_hi(uint32_t a, uint32_t b) {
+    uint32x4_t a_v = __arm_vdupq_n_u32(a);
+    uint32x4_t b_v = __arm_vdupq_n_u32(b);
+    a_v = __arm_vsetq_lane_u32(a << 16, a_v, 2);
+    b_v = __arm_vsetq_lane_u32(b << 16, b_v, 1);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)a_v, (uint16x8_t)b_v);
+
+    return __arm_vgetq_lane_u32(x_v, 0)
+            ^ (__arm_vgetq_lane_u32(x_v, 1) >> 16)
+            ^ (__arm_vgetq_lane_u32(x_v, 2) >> 16);
+}
+
+static inline uint32x4_t reduce8(uint32x4_t folded_v, uint8_t d) {
+    // Barret reduce 8-bit bytes
+    uint32_t crc = __arm_vgetq_lane_u32(folded_v, 0) ^ d;
+    uint32_t b = pmul32(crc << 24, 0xdea713f1);
+    crc = (crc >> 8) ^ pmul32_hi(b, 0x05ec76f1) ^ b;
+    return __arm_vsetq_lane_u32(crc, folded_v, 0);
+}
+
+static inline uint32x4_t reduce32(
+        uint32x4_t folded_v, uint32_t *overflow, uint32_t d) {
+    // Barret reduce 32-bit words
+    uint32_t crc = __arm_vgetq_lane_u32(folded_v, 0) ^ d;
+    uint32_t b = pmul32(crc, 0xdea713f1);
+    crc = __arm_vgetq_lane_u32(folded_v, 1) ^ pmul32_hi(b, 0x05ec76f1) ^ b;
+    folded_v = __arm_vsetq_lane_u32(crc, folded_v, 0);
+    folded_v = __arm_vsetq_lane_u32(
+            __arm_vgetq_lane_u32(folded_v, 2), folded_v, 1);
+    folded_v = __arm_vsetq_lane_u32(
+            __arm_vgetq_lane_u32(folded_v, 3), folded_v, 2);
+    folded_v = __arm_vsetq_lane_u32(*overflow, folded_v, 3);
+    *overflow = 0;
+    return folded_v;
+}
+
+static inline uint32x4_t fold128(
+        uint32x4_t folded_v, uint32_t *overflow,
+        uint32x4_t k_lower_v, uint32x4_t k_upper_v) {
+    // 2x p16xp32 -> p48 folds
+    uint32x4_t lower0_v = __arm_vmullbq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_lower_v);
+    uint32x4_t lower1_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_lower_v);
+    uint32x4_t upper0_v = __arm_vmullbq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_upper_v);
+    uint32x4_t upper1_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_upper_v);
+    // xor/shift into folded
+    uint32x4_t lower_v = __arm_veorq_u32(lower0_v, lower1_v);
+    uint32x4_t upper_v = __arm_veorq_u32(upper0_v, upper1_v);
+    return __arm_veorq_u32(lower_v,
+            __arm_vshlcq_u32(upper_v, overflow, 16));
+}
+
+// fold our state a long distance, the overflow is already 128-bits ahead
+// of folded, so it needs its own fold that is 128-bits shorter
+static inline uint32x4_t longfold(
+        uint32x4_t folded_v, uint32_t *overflow,
+        uint32_t k_lower, uint32_t k_upper,
+        uint32_t k_lower_short, uint32_t k_upper_short) {
+    uint32_t carry = 0;
+    uint32_t overflow_carry = 0;
+    folded_v = __arm_veorq_u32(
+            fold128(folded_v, &carry,
+                __arm_vdupq_n_u32(k_lower),
+                __arm_vdupq_n_u32(k_upper)),
+            fold128(
+                __arm_vsetq_lane_u32(*overflow, __arm_vdupq_n_u32(0), 0),
+                &overflow_carry,
+                __arm_vdupq_n_u32(k_lower_short),
+                __arm_vdupq_n_u32(k_upper_short)));
+    *overflow = carry ^ overflow_carry;
+    return folded_v;
+}
+
+// constants for folding n bits, with k(m) = x^(m-1) mod P:
+//
+// k_lower = k(n+16)[15:0] << 16 | k(n+32)[15:0]
+// k_upper = k(n+16)[31:16] << 16 | k(n+32)[31:16]
+//
+// and the same 128-bits shorter for the overflow, these are all k(n-112)
+// times x^16, x^128, or x^144, see ./constants.py -s <stripe>
+static inline void longfold_constants(uint64_t n, uint32_t k[4]) {
+    uint32_t k_short = crc32c_xpow(n-113);
+    uint32_t k16_short = crc32c_mulmod(k_short, 0x00008000);
+    uint32_t k16 = crc32c_mulmod(k_short, 0x18b8ea18);
+    uint32_t k32 = crc32c_mulmod(k_short, 0x2a03aaa3);
+    k[0] = (k16 << 16) | (k32 & 0xffff);
+    k[1] = (k16 & 0xffff0000) | (k32 >> 16);
+    k[2] = (k_short << 16) | (k16_short & 0xffff);
+    k[3] = (k_short & 0xffff0000) | (k16_short >> 16);
+}
+
+uint32_t crc32c_folding_vmullp16_3x8x16wide(
+        uint32_t crc, const void *data, size_t size) {
+    const uint8_t *data_ = data;
+    crc = crc ^ 0xffffffff;
+
+    // fold by 128 bits, k160/k144
+    uint32x4_t k_lower_v = __arm_vdupq_n_u32(0x55460dfe);
+    uint32x4_t k_upper_v = __arm_vdupq_n_u32(0x5407f20c);
+
+    uint32x4_t folded_v = __arm_vsetq_lane_u32(crc, __arm_vdupq_n_u32(0), 0);
+    uint32_t overflow = 0;
+
+    // bytes/words until aligned
+    size_t i = 0;
+    for (; i < size && ((uintptr_t)&data_[i]) % 4 != 0; i++) {
+        folded_v = reduce8(folded_v, data_[i]);
+    }
+    for (; i+4 <= size && ((uintptr_t)&data_[i]) % 16 != 0; i += 4) {
+        folded_v = reduce32(folded_v, &overflow, *(const uint32_t*)&data_[i]);
+    }
+
+    // 3 equal stripes, leaving the last 128-bits for the tail
+    if (i+3*STRIPE_MIN+16 <= size) {
+        size_t stripe = ((size-16 - i) / 3) & ~(size_t)15;
+        const uint32_t *a = (const uint32_t*)&data_[i];
+        const uint32_t *b = a + stripe/4;
+        const uint32_t *c = b + stripe/4;
+
+        // the first stream carries our state, the others start at zero
+        uint32x4_t a_v = folded_v;
+        uint32x4_t b_v = __arm_vdupq_n_u32(0);
+        uint32x4_t c_v = __arm_vdupq_n_u32(0);
+        uint32_t a_overflow = overflow;
+        uint32_t b_overflow = 0;
+        uint32_t c_overflow = 0;
+
+        for (size_t k = 0; k < stripe/16; k++) {
+            a_v = fold128(
+                    __arm_veorq_u32(a_v, __arm_vld1q_u32(&a[4*k])),
+                    &a_overflow, k_lower_v, k_upper_v);
+            b_v = fold128(
+                    __arm_veorq_u32(b_v, __arm_vld1q_u32(&b[4*k])),
+                    &b_overflow, k_lower_v, k_upper_v);
+            c_v = fold128(
+                    __arm_veorq_u32(c_v, __arm_vld1q_u32(&c[4*k])),
+                    &c_overflow, k_lower_v, k_upper_v);
+        }
+
+        // merge a and b into c with long folds, by 2 stripes and by 1
+        // stripe
+        uint32_t k2[4];
+        uint32_t k1[4];
+        longfold_constants(16*(uint64_t)stripe, k2);
+        longfold_constants(8*(uint64_t)stripe, k1);
+        a_v = longfold(a_v, &a_overflow, k2[0], k2[1], k2[2], k2[3]);
+        b_v = longfold(b_v, &b_overflow, k1[0], k1[1], k1[2], k1[3]);
+        folded_v = __arm_veorq_u32(c_v, __arm_veorq_u32(a_v, b_v));
+        overflow = c_overflow ^ a_overflow ^ b_overflow;
+
+        i += 3*stripe;
+    }
+
+    // aligned folds, leaving the last 128-bits for the tail to reduce
+    if (i+16+16 <= size) {
+        const uint32_t *blocks = (const uint32_t*)&data_[i];
+        size_t count = (size-16 - i) / 16;
+        for (size_t j = 0; j < count; j++) {
+            folded_v = fold128(
+                    __arm_veorq_u32(folded_v, __arm_vld1q_u32(&blocks[4*j])),
+                    &overflow, k_lower_v, k_upper_v);
+        }
+        i += 16*count;
+    }
+
+    // trailing words/bytes
+    for (; i+4 <= size; i += 4) {
+        folded_v = reduce32(folded_v, &overflow, *(const uint32_t*)&data_[i]);
+    }
+    for (; i < size; i++) {
+        folded_v = reduce8(folded_v, data_[i]);
+    }
+
+    return __arm_vgetq_lane_u32(folded_v, 0) ^ 0xffffffff;
+}
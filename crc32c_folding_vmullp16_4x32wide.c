@@ -8,16 +8,6 @@
 #include <arm_mve.h>
 
 
-static inline uint32_t rbit32(uint32_t a) {
-    uint32_t x;
-    __asm__(
-        "rbit %0,%1"
-        : "=r"(x)
-        : "r"(a)
-    );
-    return x;
-}
-
 static inline uint32_t pmul32(uint32_t a, uint32_t b) {
     uint16x8_t a_v = __arm_vdupq_n_u16(a);
     uint16x8_t b_v = __arm_vdupq_n_u16(b);
@@ -31,6 +21,43 @@ static inline uint32_t pmul32(uint32_t a, uint32_t b) {
             ^ (__arm_vgetq_lane_u32(x_v, 2) << 16);
 }
 
+// upper 32-bits of a 32x32 pmul, hi*hi ^ (hi*lo ^ lo*hi) >> 16
+static inline uint32_t pmul32_hi(uint32_t a, uint32_t b) {
+    uint32x4_t a_v = __arm_vdupq_n_u32(a);
+    uint32x4_t b_v = __arm_vdupq_n_u32(b);
+    a_v = __arm_vsetq_lane_u32(a << 16, a_v, 2);
+    b_v = __arm_vsetq_lane_u32(b << 16, b_v, 1);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)a_v, (uint16x8_t)b_v);
+
+    return __arm_vgetq_lane_u32(x_v, 0)
+            ^ (__arm_vgetq_lane_u32(x_v, 1) >> 16)
+            ^ (__arm_vgetq_lane_u32(x_v, 2) >> 16);
+}
+
+static inline uint32x4_t reduce8(uint32x4_t folded_v, uint8_t d) {
+    // Barret reduce 8-bit bytes
+    uint32_t crc = __arm_vgetq_lane_u32(folded_v, 0) ^ d;
+    uint32_t b = pmul32(crc << 24, 0xdea713f1);
+    crc = (crc >> 8) ^ pmul32_hi(b, 0x05ec76f1) ^ b;
+    return __arm_vsetq_lane_u32(crc, folded_v, 0);
+}
+
+static inline uint32x4_t reduce32(
+        uint32x4_t folded_v, uint32_t d) {
+    // Barret reduce 32-bit words
+    uint32_t crc = __arm_vgetq_lane_u32(folded_v, 0) ^ d;
+    uint32_t b = pmul32(crc, 0xdea713f1);
+    crc = __arm_vgetq_lane_u32(folded_v, 1) ^ pmul32_hi(b, 0x05ec76f1) ^ b;
+    folded_v = __arm_vsetq_lane_u32(crc, folded_v, 0);
+    folded_v = __arm_vsetq_lane_u32(
+            __arm_vgetq_lane_u32(folded_v, 2), folded_v, 1);
+    folded_v = __arm_vsetq_lane_u32(
+            __arm_vgetq_lane_u32(folded_v, 3), folded_v, 2);
+    return __arm_vsetq_lane_u32(0, folded_v, 3);
+}
+
 uint32_t crc32c_folding_vmullp16_4x32wide(
         uint32_t crc, const void *data, size_t size) {
     const uint8_t *data_ = data;
@@ -43,11 +70,23 @@ uint32_t crc32c_folding_vmullp16_4x32wide(
 
     uint32x4_t folded_v = __arm_vsetq_lane_u32(crc, __arm_vdupq_n_u32(0), 0);
 
-    for (size_t i = 0; i < size;) {
-        if (((uintptr_t)&data_[i]) % 16 == 0 && i+16+16 <= size) {
+    // bytes/words until aligned
+    size_t i = 0;
+    for (; i < size && ((uintptr_t)&data_[i]) % 4 != 0; i++) {
+        folded_v = reduce8(folded_v, data_[i]);
+    }
+    for (; i+4 <= size && ((uintptr_t)&data_[i]) % 16 != 0; i += 4) {
+        folded_v = reduce32(folded_v, *(const uint32_t*)&data_[i]);
+    }
+
+    // aligned folds, leaving the last 128-bits for the tail to reduce
+    if (i+16+16 <= size) {
+        const uint32_t *blocks = (const uint32_t*)&data_[i];
+        size_t count = (size-16 - i) / 16;
+        for (size_t j = 0; j < count; j++) {
             // xor data into folded
             folded_v = __arm_veorq_u32(folded_v,
-                    __arm_vld1q_u32((const uint32_t*)&data_[i]));
+                    __arm_vld1q_u32(&blocks[4*j]));
             // fold using emulated 32-bit pmul
             uint32x4_t lolo_v = __arm_vmullbq_poly_p16(
                     (uint16x8_t)folded_v, (uint16x8_t)k_v);
@@ -75,30 +114,16 @@ uint32_t crc32c_folding_vmullp16_4x32wide(
                             &(uint32_t){0},
                             16),
                         0x3c3c);
-            i += 16;
-        } else if (((uintptr_t)&data_[i]) % 4 == 0 && i+4 <= size) {
-            // Barret reduce 32-bit words
-            crc = __arm_vgetq_lane_u32(folded_v, 0)
-                    ^ *(const uint32_t*)&data_[i];
-            crc = __arm_vgetq_lane_u32(folded_v, 1) ^ rbit32(pmul32(
-                    rbit32(pmul32(crc, 0xdea713f1)),
-                    0x1edc6f41));
-            folded_v = __arm_vsetq_lane_u32(crc, folded_v, 0);
-            folded_v = __arm_vsetq_lane_u32(
-                    __arm_vgetq_lane_u32(folded_v, 2), folded_v, 1);
-            folded_v = __arm_vsetq_lane_u32(
-                    __arm_vgetq_lane_u32(folded_v, 3), folded_v, 2);
-            folded_v = __arm_vsetq_lane_u32(0, folded_v, 3);
-            i += 4;
-        } else {
-            // Barret reduce 8-bit bytes
-            crc = __arm_vgetq_lane_u32(folded_v, 0) ^ data_[i];
-            crc = (crc >> 8) ^ rbit32(pmul32(
-                    rbit32(pmul32(crc << 24, 0xdea713f1)),
-                    0x1edc6f41));
-            folded_v = __arm_vsetq_lane_u32(crc, folded_v, 0);
-            i += 1;
         }
+        i += 16*count;
+    }
+
+    // trailing words/bytes
+    for (; i+4 <= size; i += 4) {
+        folded_v = reduce32(folded_v, *(const uint32_t*)&data_[i]);
+    }
+    for (; i < size; i++) {
+        folded_v = reduce8(folded_v, data_[i]);
     }
 
     return __arm_vgetq_lane_u32(folded_v, 0) ^ 0xffffffff;
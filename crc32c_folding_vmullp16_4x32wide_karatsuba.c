@@ -0,0 +1,136 @@
+// A crc32c implementation using polynomial folding leveraging ARMv8-M's MVE
+// vmull.p16 instruction, 4 32-bit words at a time by emulating 32-bit pmul
+// with Karatsuba multiplication, 3 p16 multiplies instead of 4
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <arm_mve.h>
+
+
+static inline uint32_t pmul32(uint32_t a, uint32_t b) {
+    uint16x8_t a_v = __arm_vdupq_n_u16(a);
+    uint16x8_t b_v = __arm_vdupq_n_u16(b);
+    a_v = (uint16x8_t)__arm_vsetq_lane_u32(a, (uint32x4_t)a_v, 1);
+    b_v = (uint16x8_t)__arm_vsetq_lane_u32(b, (uint32x4_t)b_v, 2);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(a_v, b_v);
+
+    return __arm_vgetq_lane_u32(x_v, 0)
+            ^ (__arm_vgetq_lane_u32(x_v, 1) << 16)
+            ^ (__arm_vgetq_lane_u32(x_v, 2) << 16);
+}
+
+// upper 32-bits of a 32x32 pmul, hi*hi ^ (hi*lo ^ lo*hi) >> 16
+static inline uint32_t pmul32_hi(uint32_t a, uint32_t b) {
+    uint32x4_t a_v = __arm_vdupq_n_u32(a);
+    uint32x4_t b_v = __arm_vdupq_n_u32(b);
+    a_v = __arm_vsetq_lane_u32(a << 16, a_v, 2);
+    b_v = __arm_vsetq_lane_u32(b << 16, b_v, 1);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)a_v, (uint16x8_t)b_v);
+
+    return __arm_vgetq_lane_u32(x_v, 0)
+            ^ (__arm_vgetq_lane_u32(x_v, 1) >> 16)
+            ^ (__arm_vgetq_lane_u32(x_v, 2) >> 16);
+}
+
+static inline uint32x4_t reduce8(uint32x4_t folded_v, uint8_t d) {
+    // Barret reduce 8-bit bytes
+    uint32_t crc = __arm_vgetq_lane_u32(folded_v, 0) ^ d;
+    uint32_t b = pmul32(crc << 24, 0xdea713f1);
+    crc = (crc >> 8) ^ pmul32_hi(b, 0x05ec76f1) ^ b;
+    return __arm_vsetq_lane_u32(crc, folded_v, 0);
+}
+
+static inline uint32x4_t reduce32(
+        uint32x4_t folded_v, uint32_t d) {
+    // Barret reduce 32-bit words
+    uint32_t crc = __arm_vgetq_lane_u32(folded_v, 0) ^ d;
+    uint32_t b = pmul32(crc, 0xdea713f1);
+    crc = __arm_vgetq_lane_u32(folded_v, 1) ^ pmul32_hi(b, 0x05ec76f1) ^ b;
+    folded_v = __arm_vsetq_lane_u32(crc, folded_v, 0);
+    folded_v = __arm_vsetq_lane_u32(
+            __arm_vgetq_lane_u32(folded_v, 2), folded_v, 1);
+    folded_v = __arm_vsetq_lane_u32(
+            __arm_vgetq_lane_u32(folded_v, 3), folded_v, 2);
+    return __arm_vsetq_lane_u32(0, folded_v, 3);
+}
+
+uint32_t crc32c_folding_vmullp16_4x32wide_karatsuba(
+        uint32_t crc, const void *data, size_t size) {
+    const uint8_t *data_ = data;
+    crc = crc ^ 0xffffffff;
+
+    uint32x4_t k_v = __arm_vld1q_u32((const uint32_t[]){
+        0xf20c0dfe, 0x3171d430, 0xf20c0dfe, 0x3171d430
+    });
+    // k_lo^k_hi in both halves, for the middle product
+    uint32x4_t k_mid_v = __arm_veorq_u32(k_v,
+            (uint32x4_t)__arm_vrev32q_u16((uint16x8_t)k_v));
+
+    uint32x4_t folded_v = __arm_vsetq_lane_u32(crc, __arm_vdupq_n_u32(0), 0);
+
+    // bytes/words until aligned
+    size_t i = 0;
+    for (; i < size && ((uintptr_t)&data_[i]) % 4 != 0; i++) {
+        folded_v = reduce8(folded_v, data_[i]);
+    }
+    for (; i+4 <= size && ((uintptr_t)&data_[i]) % 16 != 0; i += 4) {
+        folded_v = reduce32(folded_v, *(const uint32_t*)&data_[i]);
+    }
+
+    // aligned folds, leaving the last 128-bits for the tail to reduce
+    if (i+16+16 <= size) {
+        const uint32_t *blocks = (const uint32_t*)&data_[i];
+        size_t count = (size-16 - i) / 16;
+        for (size_t j = 0; j < count; j++) {
+            // xor data into folded
+            folded_v = __arm_veorq_u32(folded_v,
+                    __arm_vld1q_u32(&blocks[4*j]));
+            // fold using emulated 32-bit pmul, Karatsuba gets the middle
+            // terms from (f_lo^f_hi)*(k_lo^k_hi) = lolo^lohi^hilo^hihi
+            uint32x4_t lolo_v = __arm_vmullbq_poly_p16(
+                    (uint16x8_t)folded_v, (uint16x8_t)k_v);
+            uint32x4_t hihi_v = __arm_vmulltq_poly_p16(
+                    (uint16x8_t)folded_v, (uint16x8_t)k_v);
+            uint32x4_t mid_v = __arm_vmullbq_poly_p16(
+                    __arm_veorq_u16(
+                        (uint16x8_t)folded_v,
+                        __arm_vrev32q_u16((uint16x8_t)folded_v)),
+                    (uint16x8_t)k_mid_v);
+            mid_v = __arm_veorq_u32(mid_v,
+                    __arm_veorq_u32(lolo_v, hihi_v));
+            // xor everything together
+            folded_v = __arm_veorq_u32(
+                    lolo_v,
+                    __arm_vrev64q_u32(lolo_v));
+            folded_v = __arm_veorq_m_u32(folded_v,
+                    hihi_v,
+                    __arm_vrev64q_u32(hihi_v),
+                    0xf0f0);
+            folded_v = __arm_veorq_m_u32(folded_v,
+                        folded_v,
+                        __arm_vshlcq_u32(
+                            __arm_veorq_u32(
+                                mid_v,
+                                __arm_vrev64q_u32(mid_v)),
+                            &(uint32_t){0},
+                            16),
+                        0x3c3c);
+        }
+        i += 16*count;
+    }
+
+    // trailing words/bytes
+    for (; i+4 <= size; i += 4) {
+        folded_v = reduce32(folded_v, *(const uint32_t*)&data_[i]);
+    }
+    for (; i < size; i++) {
+        folded_v = reduce8(folded_v, data_[i]);
+    }
+
+    return __arm_vgetq_lane_u32(folded_v, 0) ^ 0xffffffff;
+}
+
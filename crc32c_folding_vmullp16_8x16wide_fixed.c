@@ -0,0 +1,142 @@
+// A crc32c implementation using polynomial folding leveraging ARMv8-M's MVE
+// vmull.p16 instruction, 8 16-bit halfwords at a time, specialized for
+// fixed-size 16-byte aligned blocks
+//
+// This provides crc32c_512_aligned and crc32c_4096_aligned, which know
+// their size and alignment at compile-time, so there is no head/tail
+// handling and the fold loop is unrolled. The generic entry point here
+// only dispatches to these, falling back to
+// crc32c_folding_vmullp16_8x16wide for anything else.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <arm_mve.h>
+
+
+static inline uint32_t pmul32(uint32_t a, uint32_t b) {
+    uint16x8_t a_v = __arm_vdupq_n_u16(a);
+    uint16x8_t b_v = __arm_vdupq_n_u16(b);
+    a_v = (uint16x8_t)__arm_vsetq_lane_u32(a, (uint32x4_t)a_v, 1);
+    b_v = (uint16x8_t)__arm_vsetq_lane_u32(b, (uint32x4_t)b_v, 2);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(a_v, b_v);
+
+    return __arm_vgetq_lane_u32(x_v, 0)
+            ^ (__arm_vgetq_lane_u32(x_v, 1) << 16)
+            ^ (__arm_vgetq_lane_u32(x_v, 2) << 16);
+}
+
+// upper 32-bits of a 32x32 pmul, hi*hi ^ (hi*lo ^ lo*hi) >> 16
+static inline uint32_t pmul32_hi(uint32_t a, uint32_t b) {
+    uint32x4_t a_v = __arm_vdupq_n_u32(a);
+    uint32x4_t b_v = __arm_vdupq_n_u32(b);
+    a_v = __arm_vsetq_lane_u32(a << 16, a_v, 2);
+    b_v = __arm_vsetq_lane_u32(b << 16, b_v, 1);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)a_v, (uint16x8_t)b_v);
+
+    return __arm_vgetq_lane_u32(x_v, 0)
+            ^ (__arm_vgetq_lane_u32(x_v, 1) >> 16)
+            ^ (__arm_vgetq_lane_u32(x_v, 2) >> 16);
+}
+
+static inline uint32_t reduce32(uint32_t crc, uint32_t d) {
+    // Barret reduce 32-bit words
+    uint32_t b = pmul32(crc ^ d, 0xdea713f1);
+    return pmul32_hi(b, 0x05ec76f1) ^ b;
+}
+
+static inline uint32x4_t fold128(
+        uint32x4_t folded_v, uint32_t *overflow,
+        uint32x4_t k_lower_v, uint32x4_t k_upper_v,
+        const uint32_t *data) {
+    // xor data into folded
+    folded_v = __arm_veorq_u32(folded_v, __arm_vld1q_u32(data));
+    // 2x p16xp32 -> p48 folds
+    uint32x4_t lower0_v = __arm_vmullbq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_lower_v);
+    uint32x4_t lower1_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_lower_v);
+    uint32x4_t upper0_v = __arm_vmullbq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_upper_v);
+    uint32x4_t upper1_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_upper_v);
+    // xor/shift into folded
+    uint32x4_t lower_v = __arm_veorq_u32(lower0_v, lower1_v);
+    uint32x4_t upper_v = __arm_veorq_u32(upper0_v, upper1_v);
+    return __arm_veorq_u32(lower_v,
+            __arm_vshlcq_u32(upper_v, overflow, 16));
+}
+
+// size must be a constant multiple of 64, and data must be 16-byte aligned
+static inline uint32_t crc32c_aligned(
+        uint32_t crc, const uint32_t *data, size_t size) {
+    crc = crc ^ 0xffffffff;
+
+    uint32x4_t k_lower_v = __arm_vdupq_n_u32(0x55460dfe);
+    uint32x4_t k_upper_v = __arm_vdupq_n_u32(0x5407f20c);
+
+    uint32x4_t folded_v = __arm_vsetq_lane_u32(crc, __arm_vdupq_n_u32(0), 0);
+    uint32_t overflow = 0;
+
+    // fold everything but the last 16 bytes, 4 folds at a time
+    for (size_t i = 0; i < size/64 - 1; i++) {
+        folded_v = fold128(folded_v, &overflow, k_lower_v, k_upper_v,
+                &data[16*i+ 0]);
+        folded_v = fold128(folded_v, &overflow, k_lower_v, k_upper_v,
+                &data[16*i+ 4]);
+        folded_v = fold128(folded_v, &overflow, k_lower_v, k_upper_v,
+                &data[16*i+ 8]);
+        folded_v = fold128(folded_v, &overflow, k_lower_v, k_upper_v,
+                &data[16*i+12]);
+    }
+    folded_v = fold128(folded_v, &overflow, k_lower_v, k_upper_v,
+            &data[size/4-16]);
+    folded_v = fold128(folded_v, &overflow, k_lower_v, k_upper_v,
+            &data[size/4-12]);
+    folded_v = fold128(folded_v, &overflow, k_lower_v, k_upper_v,
+            &data[size/4- 8]);
+
+    // Barret reduce the last 16 bytes, shifting in our overflow
+    crc = reduce32(
+            __arm_vgetq_lane_u32(folded_v, 0),
+            data[size/4-4]);
+    crc = reduce32(
+            crc ^ __arm_vgetq_lane_u32(folded_v, 1),
+            data[size/4-3]);
+    crc = reduce32(
+            crc ^ __arm_vgetq_lane_u32(folded_v, 2),
+            data[size/4-2]);
+    crc = reduce32(
+            crc ^ __arm_vgetq_lane_u32(folded_v, 3),
+            data[size/4-1]);
+
+    return (crc ^ overflow) ^ 0xffffffff;
+}
+
+uint32_t crc32c_512_aligned(uint32_t crc, const void *data) {
+    return crc32c_aligned(crc, data, 512);
+}
+
+uint32_t crc32c_4096_aligned(uint32_t crc, const void *data) {
+    return crc32c_aligned(crc, data, 4096);
+}
+
+
+extern uint32_t crc32c_folding_vmullp16_8x16wide(
+        uint32_t crc, const void *data, size_t size);
+
+uint32_t crc32c_folding_vmullp16_8x16wide_fixed(
+        uint32_t crc, const void *data, size_t size) {
+    if ((uintptr_t)data % 16 == 0) {
+        if (size == 4096) {
+            return crc32c_4096_aligned(crc, data);
+        } else if (size == 512) {
+            return crc32c_512_aligned(crc, data);
+        }
+    }
+
+    return crc32c_folding_vmullp16_8x16wide(crc, data, size);
+}
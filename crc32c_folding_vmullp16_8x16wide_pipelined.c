@@ -0,0 +1,145 @@
+// A crc32c implementation using polynomial folding leveraging ARMv8-M's MVE
+// vmull.p16 instruction, 8 16-bit halfwords at a time, software-pipelined
+//
+// This is the same as crc32c_folding_vmullp16_8x16wide, except the load
+// of the next block is issued between the vmulls of the current block,
+// and the data xor is moved off of the vmull chain. The loop body is
+// ordered so consecutive MVE instructions alternate between the
+// multiplier, load/store, and ALU where possible, which lets the
+// Cortex-M55 overlap their beats.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <arm_mve.h>
+
+
+static inline uint32_t pmul32(uint32_t a, uint32_t b) {
+    uint16x8_t a_v = __arm_vdupq_n_u16(a);
+    uint16x8_t b_v = __arm_vdupq_n_u16(b);
+    a_v = (uint16x8_t)__arm_vsetq_lane_u32(a, (uint32x4_t)a_v, 1);
+    b_v = (uint16x8_t)__arm_vsetq_lane_u32(b, (uint32x4_t)b_v, 2);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(a_v, b_v);
+
+    return __arm_vgetq_lane_u32(x_v, 0)
+            ^ (__arm_vgetq_lane_u32(x_v, 1) << 16)
+            ^ (__arm_vgetq_lane_u32(x_v, 2) << 16);
+}
+
+// upper 32-bits of a 32x32 pmul, hi*hi ^ (hi*lo ^ lo*hi) >> 16
+static inline uint32_t pmul32_hi(uint32_t a, uint32_t b) {
+    uint32x4_t a_v = __arm_vdupq_n_u32(a);
+    uint32x4_t b_v = __arm_vdupq_n_u32(b);
+    a_v = __arm_vsetq_lane_u32(a << 16, a_v, 2);
+    b_v = __arm_vsetq_lane_u32(b << 16, b_v, 1);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)a_v, (uint16x8_t)b_v);
+
+    return __arm_vgetq_lane_u32(x_v, 0)
+            ^ (__arm_vgetq_lane_u32(x_v, 1) >> 16)
+            ^ (__arm_vgetq_lane_u32(x_v, 2) >> 16);
+}
+
+static inline uint32x4_t reduce8(uint32x4_t folded_v, uint8_t d) {
+    // Barret reduce 8-bit bytes
+    uint32_t crc = __arm_vgetq_lane_u32(folded_v, 0) ^ d;
+    uint32_t b = pmul32(crc << 24, 0xdea713f1);
+    crc = (crc >> 8) ^ pmul32_hi(b, 0x05ec76f1) ^ b;
+    return __arm_vsetq_lane_u32(crc, folded_v, 0);
+}
+
+static inline uint32x4_t reduce32(
+        uint32x4_t folded_v, uint32_t *overflow, uint32_t d) {
+    // Barret reduce 32-bit words
+    uint32_t crc = __arm_vgetq_lane_u32(folded_v, 0) ^ d;
+    uint32_t b = pmul32(crc, 0xdea713f1);
+    crc = __arm_vgetq_lane_u32(folded_v, 1) ^ pmul32_hi(b, 0x05ec76f1) ^ b;
+    folded_v = __arm_vsetq_lane_u32(crc, folded_v, 0);
+    folded_v = __arm_vsetq_lane_u32(
+            __arm_vgetq_lane_u32(folded_v, 2), folded_v, 1);
+    folded_v = __arm_vsetq_lane_u32(
+            __arm_vgetq_lane_u32(folded_v, 3), folded_v, 2);
+    folded_v = __arm_vsetq_lane_u32(*overflow, folded_v, 3);
+    *overflow = 0;
+    return folded_v;
+}
+
+uint32_t crc32c_folding_vmullp16_8x16wide_pipelined(
+        uint32_t crc, const void *data, size_t size) {
+    const uint8_t *data_ = data;
+    crc = crc ^ 0xffffffff;
+
+    uint32x4_t k_lower_v = __arm_vdupq_n_u32(0x55460dfe);
+    uint32x4_t k_upper_v = __arm_vdupq_n_u32(0x5407f20c);
+
+    uint32x4_t folded_v = __arm_vsetq_lane_u32(crc, __arm_vdupq_n_u32(0), 0);
+    uint32_t overflow = 0;
+
+    // bytes/words until aligned
+    size_t i = 0;
+    for (; i < size && ((uintptr_t)&data_[i]) % 4 != 0; i++) {
+        folded_v = reduce8(folded_v, data_[i]);
+    }
+    for (; i+4 <= size && ((uintptr_t)&data_[i]) % 16 != 0; i += 4) {
+        folded_v = reduce32(folded_v, &overflow, *(const uint32_t*)&data_[i]);
+    }
+
+    // aligned folds, leaving the last 128-bits for the tail to reduce
+    if (i+16+16 <= size) {
+        const uint32_t *blocks = (const uint32_t*)&data_[i];
+        size_t count = (size-16 - i) / 16;
+
+        // prologue, xor in the first block
+        folded_v = __arm_veorq_u32(folded_v, __arm_vld1q_u32(&blocks[0]));
+
+        // steady state, each iteration folds block j while loading and
+        // xoring in block j+1, the comments note which unit each MVE
+        // instruction uses
+        for (size_t j = 0; j < count-1; j++) {
+            uint32x4_t lower0_v = __arm_vmullbq_poly_p16(       // mul
+                    (uint16x8_t)folded_v, (uint16x8_t)k_lower_v);
+            uint32x4_t data_v = __arm_vld1q_u32(&blocks[4*(j+1)]); // ld
+            uint32x4_t lower1_v = __arm_vmulltq_poly_p16(       // mul
+                    (uint16x8_t)folded_v, (uint16x8_t)k_lower_v);
+            uint32x4_t lower_v = __arm_veorq_u32(               // alu
+                    lower0_v, lower1_v);
+            uint32x4_t upper0_v = __arm_vmullbq_poly_p16(       // mul
+                    (uint16x8_t)folded_v, (uint16x8_t)k_upper_v);
+            lower_v = __arm_veorq_u32(lower_v, data_v);         // alu
+            uint32x4_t upper1_v = __arm_vmulltq_poly_p16(       // mul
+                    (uint16x8_t)folded_v, (uint16x8_t)k_upper_v);
+            uint32x4_t upper_v = __arm_veorq_u32(               // alu
+                    upper0_v, upper1_v);
+            folded_v = __arm_veorq_u32(lower_v,                 // alu
+                    __arm_vshlcq_u32(upper_v, &overflow, 16));
+        }
+
+        // epilogue, fold the last block with nothing to load
+        uint32x4_t lower0_v = __arm_vmullbq_poly_p16(
+                (uint16x8_t)folded_v, (uint16x8_t)k_lower_v);
+        uint32x4_t lower1_v = __arm_vmulltq_poly_p16(
+                (uint16x8_t)folded_v, (uint16x8_t)k_lower_v);
+        uint32x4_t upper0_v = __arm_vmullbq_poly_p16(
+                (uint16x8_t)folded_v, (uint16x8_t)k_upper_v);
+        uint32x4_t upper1_v = __arm_vmulltq_poly_p16(
+                (uint16x8_t)folded_v, (uint16x8_t)k_upper_v);
+        uint32x4_t lower_v = __arm_veorq_u32(lower0_v, lower1_v);
+        uint32x4_t upper_v = __arm_veorq_u32(upper0_v, upper1_v);
+        folded_v = __arm_veorq_u32(lower_v,
+                __arm_vshlcq_u32(upper_v, &overflow, 16));
+
+        i += 16*count;
+    }
+
+    // trailing words/bytes
+    for (; i+4 <= size; i += 4) {
+        folded_v = reduce32(folded_v, &overflow, *(const uint32_t*)&data_[i]);
+    }
+    for (; i < size; i++) {
+        folded_v = reduce8(folded_v, data_[i]);
+    }
+
+    return __arm_vgetq_lane_u32(folded_v, 0) ^ 0xffffffff;
+}
@@ -4,27 +4,44 @@
 #include <stdint.h>
 #include <stddef.h>
 
+static inline uint32_t reduce8(uint32_t crc, uint8_t d) {
+    crc = crc ^ d;
+    for (size_t j = 0; j < 8; j++) {
+        crc = (crc >> 1) ^ ((crc & 1) * 0x82f63b78);
+    }
+    return crc;
+}
+
+static inline uint32_t reduce32(uint32_t crc, uint32_t d) {
+    crc = crc ^ d;
+    for (size_t j = 0; j < 32; j++) {
+        crc = (crc >> 1) ^ ((crc & 1) * 0x82f63b78);
+    }
+    return crc;
+}
+
 uint32_t crc32c_naive_mul_32wide(
         uint32_t crc, const void *data, size_t size) {
     const uint8_t *data_ = data;
     crc = crc ^ 0xffffffff;
 
-    for (size_t i = 0; i < size;) {
-        if (((uintptr_t)&data_[i]) % 4 == 0 && i+4 <= size) {
-            crc = crc ^ *(const uint32_t*)&data_[i];
-            for (size_t j = 0; j < 32; j++) {
-                crc = (crc >> 1) ^ ((crc & 1) * 0x82f63b78);
-            }
-
-            i += 4;
-        } else {
-            crc = crc ^ data_[i];
-            for (size_t j = 0; j < 8; j++) {
-                crc = (crc >> 1) ^ ((crc & 1) * 0x82f63b78);
-            }
-
-            i += 1;
-        }
+    // bytes until aligned
+    size_t i = 0;
+    for (; i < size && ((uintptr_t)&data_[i]) % 4 != 0; i++) {
+        crc = reduce8(crc, data_[i]);
+    }
+
+    // aligned words
+    const uint32_t *words = (const uint32_t*)&data_[i];
+    size_t count = (size - i) / 4;
+    for (size_t j = 0; j < count; j++) {
+        crc = reduce32(crc, words[j]);
+    }
+    i += 4*count;
+
+    // trailing bytes
+    for (; i < size; i++) {
+        crc = reduce8(crc, data_[i]);
     }
 
     return crc ^ 0xffffffff;
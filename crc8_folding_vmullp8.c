@@ -0,0 +1,91 @@
+// A CRC-8 implementation using polynomial folding leveraging ARMv8-M's MVE
+// vmull.p8 instruction, 16 8-bit bytes at a time
+//
+// This is the same fold as crc16_folding_vmullp16, just with bytes.
+// vmullb folds the even bytes, which land in place, and vmullt folds the
+// odd bytes, which need to be shifted up by 8-bits with vshlc.
+//
+// Provides CRC-8/MAXIM (Dallas 1-Wire, 0x31), bit-reflected, with no
+// init/final xor, so crcs can be chained. Constants come from
+// ./constants.py -W 8 -p <polynomial>.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <arm_mve.h>
+
+
+static inline uint16_t pmul8(uint8_t a, uint8_t b) {
+    uint16x8_t x_v = __arm_vmullbq_poly_p8(
+            __arm_vdupq_n_u8(a), __arm_vdupq_n_u8(b));
+    return __arm_vgetq_lane_u16(x_v, 0);
+}
+
+static inline uint8_t reduce8(uint8_t crc, uint8_t d,
+        uint8_t barret, uint8_t polynomial) {
+    // Barret reduce 8-bit bytes
+    crc = crc ^ d;
+    uint8_t b = pmul8(crc, barret);
+    return (pmul8(b, polynomial) >> 8) ^ b;
+}
+
+static inline uint8x16_t fold128(
+        uint8x16_t folded_v, uint32_t *overflow, uint8x16_t k_v) {
+    // p8xp8 -> p16 folds
+    uint16x8_t lower_v = __arm_vmullbq_poly_p8(folded_v, k_v);
+    uint16x8_t upper_v = __arm_vmulltq_poly_p8(folded_v, k_v);
+    // xor/shift into folded
+    return (uint8x16_t)__arm_veorq_u32((uint32x4_t)lower_v,
+            __arm_vshlcq_u32((uint32x4_t)upper_v, overflow, 8));
+}
+
+static inline uint8_t crc8_folding(
+        uint8_t crc, const void *data, size_t size,
+        uint8_t k, uint8_t barret, uint8_t polynomial) {
+    const uint8_t *data_ = data;
+
+    // bytes until aligned
+    size_t i = 0;
+    for (; i < size && ((uintptr_t)&data_[i]) % 16 != 0; i++) {
+        crc = reduce8(crc, data_[i], barret, polynomial);
+    }
+
+    // aligned folds, leaving the last 128-bits for the tail to reduce
+    if (i+16+16 <= size) {
+        uint8x16_t k_v = __arm_vdupq_n_u8(k);
+        uint8x16_t folded_v = (uint8x16_t)__arm_vsetq_lane_u32(
+                crc, __arm_vdupq_n_u32(0), 0);
+        uint32_t overflow = 0;
+
+        size_t count = (size-16 - i) / 16;
+        for (size_t j = 0; j < count; j++) {
+            folded_v = fold128(
+                    __arm_veorq_u8(folded_v, __arm_vld1q_u8(&data_[i])),
+                    &overflow, k_v);
+            i += 16;
+        }
+
+        // reduce our folded state with the last 128-bits, the overflow
+        // is 128-bits ahead, which is where our crc is
+        uint8_t folded[16];
+        __arm_vst1q_u8(folded, folded_v);
+        crc = 0;
+        for (size_t j = 0; j < 16; j++, i++) {
+            crc = reduce8(crc, data_[i] ^ folded[j], barret, polynomial);
+        }
+        crc ^= overflow;
+    }
+
+    // trailing bytes
+    for (; i < size; i++) {
+        crc = reduce8(crc, data_[i], barret, polynomial);
+    }
+
+    return crc;
+}
+
+uint8_t crc8_maxim_folding_vmullp8(
+        uint8_t crc, const void *data, size_t size) {
+    // fold by 128 bits, k136
+    return crc8_folding(crc, data, size, 0x8c, 0x59, 0x19);
+}
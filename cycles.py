@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+#
+# Estimate cycles for an executed trace with a rough model of the
+# Cortex-M55's in-order pipeline and beat-wise MVE execution
+#
+# The M55 executes 128-bit MVE instructions as 4 32-bit beats, 2 beats per
+# cycle, so each MVE instruction takes 2 cycles. Consecutive MVE
+# instructions can overlap by a cycle, the second starting its first half
+# while the first finishes its second half, but only if they use different
+# execution units (load/store, multiply, ALU), and if any dependency
+# between them is lane-wise.
+#
+# This is NOT cycle-accurate, the real pipeline has more hazards than this
+# models, but it does capture the effect of instruction ordering, which an
+# instruction count can't. Registers/dependencies come from deps.py.
+#
+
+import re
+import collections as co
+
+import deps
+
+
+# MVE execution units, anything else starting with v is the ALU
+UNITS = {
+    'ld/st': r'(vldr.*|vstr.*|vld[24].*|vst[24].*|vpush|vpop)',
+    'mul': r'(vmul.*|vmla.*|vmls.*|vqdmul.*|vqrdmul.*|vfma.*|vfms.*'
+        r'|vrmlal.*|vmlal.*)',
+}
+
+# extra cycles before an MVE unit's results are ready
+UNIT_LATENCY = {
+    'ld/st': 1,
+    'mul': 1,
+    'alu': 0,
+}
+
+# scalar latencies, everything else is 1
+SCALAR_LATENCIES = {
+    'load': (r'(ldr.*|ldm.*|pop)', 2),
+}
+
+# MVE instructions that move data across beats, or between vector and
+# scalar registers, these can't chain off of a partial result
+CROSS_BEAT = re.compile(
+    r'(vshlc|vmov|vdup.*|vrev.*|vaddv.*|vaddlv.*|vmladav.*|vmlaldav.*'
+    r'|vrmlaldavh.*|vminv.*|vmaxv.*|vctp.*|vpst.*|vpt.*|vcmp.*|vmsr|vmrs'
+    r'|vldr.*gather.*|vstr.*scatter.*)(\.|$)')
+
+# instructions the M55 handles without issuing, low-overhead loop ends
+FREE = re.compile(r'(le|letp)$')
+
+
+def unit(ins):
+    if not ins.startswith('v'):
+        return None
+    for name, pattern in UNITS.items():
+        if re.match(pattern + '$', ins):
+            return name
+    return 'alu'
+
+def schedule(trace):
+    """Assign a start/finish cycle to each instruction, returns the total
+    cycles and number of overlapped MVE pairs"""
+    # when each register's first half/full value is ready
+    half = {}
+    full = {}
+    # when each MVE unit is next free
+    busy = co.defaultdict(int)
+
+    # unit/cross-beat-ness of the previous instruction
+    prev = None
+    prev_u = None
+    prev_cross = False
+    t = 0
+    overlaps = 0
+    for ins in trace:
+        u = unit(ins.ins)
+        cross = bool(CROSS_BEAT.match(ins.ins))
+        if FREE.match(ins.ins):
+            ins.start = t
+            ins.finish = t
+            for r in ins.defs:
+                half[r] = full[r] = t
+            continue
+
+        if u:
+            # MVE instruction, may overlap the previous one's second half
+            # if they use different units
+            start = t
+            if prev is not None and not (
+                    prev_u and prev_u != u and not cross and not prev_cross):
+                start = max(start, prev.finish)
+            # unit is busy for both halves
+            start = max(start, busy[u])
+            # first half needs the first half of its inputs, unless this
+            # moves data across beats, second half needs everything
+            for r in ins.uses:
+                if cross:
+                    start = max(start, full.get(r, 0))
+                else:
+                    start = max(start, half.get(r, 0), full.get(r, 0) - 1)
+            if prev is not None and prev_u and start < prev.finish:
+                overlaps += 1
+
+            ins.start = start
+            ins.finish = start + 2
+            busy[u] = start + 2
+            lat = UNIT_LATENCY[u]
+            for r in ins.defs:
+                # scalar results of MVE instructions (vmov r, q[n]) are
+                # only ready when everything is
+                if cross or not r.startswith('q'):
+                    half[r] = full[r] = ins.finish + lat
+                else:
+                    half[r] = start + 1 + lat
+                    full[r] = ins.finish + lat
+            t = ins.start + 1
+        else:
+            # scalar instruction, no overlap with MVE instructions
+            start = max(t, prev.finish if prev is not None else 0)
+            for r in ins.uses:
+                start = max(start, full.get(r, 0))
+            lat = 1
+            for pattern, lat_ in SCALAR_LATENCIES.values():
+                if re.match(pattern + '$', ins.ins):
+                    lat = lat_
+                    break
+
+            ins.start = start
+            ins.finish = start + 1
+            for r in ins.defs:
+                half[r] = full[r] = start + lat
+            t = ins.finish
+
+        prev = ins
+        prev_u = u
+        prev_cross = cross
+
+    cycles = max((ins.finish for ins in trace), default=0)
+    return cycles, overlaps
+
+def main(paths, **args):
+    print('%-42s %7s %7s %7s %7s %9s' % (
+        '', 'ins', 'cycles', 'ipc', 'overlap', 'cyc/iter'))
+    for path in paths:
+        trace = deps.collect(path)
+        if not trace:
+            print('%s: no instructions found?' % path)
+            continue
+        cycles, overlaps = schedule(trace)
+
+        # cycles per iteration of the hottest loop, skipping the first and
+        # last iterations
+        head, iters = deps.find_loop(trace, **args)
+        if len(iters) > 2:
+            steady = iters[1:-1]
+            per_iter = '%9.1f' % (
+                (trace[steady[-1][1]].start - trace[steady[0][0]].start)
+                    / len(steady))
+        else:
+            per_iter = '%9s' % '-'
+
+        print('%-42s %7d %7d %7.2f %7d %s' % (
+            re.sub(r'\.trace$', '', path),
+            len(trace),
+            cycles,
+            len(trace) / cycles if cycles else 0,
+            overlaps,
+            per_iter))
+
+        if args.get('verbose'):
+            for ins in trace:
+                print('%7d %7d  %-10s %s' % (
+                    ins.start, ins.finish, ins.ins, ins.operands))
+
+
+if __name__ == "__main__":
+    import argparse
+    import sys
+    parser = argparse.ArgumentParser(
+        description="Estimate Cortex-M55 cycles for executed traces.")
+    parser.add_argument('paths', nargs='+',
+        help="Trace files to analyze.")
+    parser.add_argument('-L', '--loop',
+        help="Address of the loop head to analyze, defaults to the "
+            "hottest backwards branch target.")
+    parser.add_argument('-v', '--verbose', action='store_true',
+        help="Show the schedule for every instruction.")
+    sys.exit(main(**vars(parser.parse_args())))
@@ -0,0 +1,450 @@
+#!/usr/bin/env python3
+#
+# Rebuild register dependencies from an executed trace, and use them to
+# find the critical path per loop iteration, available instruction-level
+# parallelism, and the longest dependent chains in the hottest loop
+#
+# This assumes infinite execution resources, so it's an upper bound on
+# what reordering/restructuring can get us, not a cycle count.
+#
+
+import re
+import collections as co
+
+
+# rough latencies for --latency, everything else is 1
+LATENCIES = {
+    'vmul': (r'vmul.*', 2),
+    'vload': (r'vldr.*', 2),
+    'vector': (r'v.*', 1),
+    'load': (r'(ldr.*|ldm.*|pop)', 2),
+    'mul': (r'(mul.*|umull|smull|mla.*|umlal|smlal)', 1),
+}
+
+# register aliases
+REG_ALIASES = {
+    'sb': 'r9',
+    'sl': 'r10',
+    'fp': 'r11',
+    'ip': 'r12',
+    'r13': 'sp',
+    'r14': 'lr',
+    'r15': 'pc',
+}
+
+# unary ops, two operands doesn't mean dest is read
+UNARY = re.compile(r'(mov.*|mvn.*|rbit|rev.*|clz|uxt.*|sxt.*|neg.*)$')
+# ops that read their dest
+READ_DEST = re.compile(
+    r'(movt|bfi|bfc|vsli.*|vsri.*|vshlc|vmla.*|vfma.*|vfms.*'
+    r'|vaddva.*|vmladava.*|vmlaldava.*|vmovnb.*|vmovnt.*'
+    r'|vqmovnb.*|vqmovnt.*|umlal|smlal)$')
+# ops with two dests
+TWO_DEST = re.compile(r'(umull|smull|umlal|smlal|ldrd.*|strd.*'
+    r'|vmlaldav.*|vrmlaldavh.*)$')
+# flag setting ops
+SET_FLAGS = re.compile(r'(adds|adcs|subs|sbcs|rsbs|negs|muls|movs|mvns'
+    r'|lsls|lsrs|asrs|rors|ands|orrs|orns|eors|bics)$')
+CONDS = ('eq|ne|cs|hs|cc|lo|mi|pl|vs|vc|hi|ls|ge|lt|gt|le')
+
+
+def parse_reg(reg):
+    reg = reg.strip().lower()
+    reg = REG_ALIASES.get(reg, reg)
+    m = re.match(r'([rqds])([0-9]+)$', reg)
+    if m:
+        k, n = m.group(1), int(m.group(2))
+        # d/s registers alias q registers, track at q granularity
+        if k == 'd':
+            return 'q%d' % (n//2)
+        elif k == 's':
+            return 'q%d' % (n//4)
+        else:
+            return '%s%d' % (k, n)
+    elif reg in {'sp', 'lr', 'pc'}:
+        return reg
+    elif reg in {'p0', 'vpr'}:
+        return 'vpr'
+    elif reg in {'apsr', 'apsr_nzcv'}:
+        return 'flags'
+    else:
+        return None
+
+def parse_reglist(s):
+    regs = []
+    for r in s.split(','):
+        r = r.strip()
+        m = re.match(r'([rds])([0-9]+)\s*-\s*[rds]([0-9]+)$', r)
+        if m:
+            for n in range(int(m.group(2)), int(m.group(3))+1):
+                regs.append(parse_reg('%s%d' % (m.group(1), n)))
+        else:
+            reg = parse_reg(r)
+            if reg:
+                regs.append(reg)
+    return regs
+
+def split_operands(s):
+    # split on commas, but not inside brackets/braces
+    ops = []
+    depth = 0
+    op = ''
+    for c in s:
+        if c in '[{':
+            depth += 1
+        elif c in ']}':
+            depth -= 1
+        if c == ',' and depth == 0:
+            ops.append(op.strip())
+            op = ''
+        else:
+            op += c
+    if op.strip():
+        ops.append(op.strip())
+    return ops
+
+def operand_regs(op):
+    # find all registers in an operand, including q0[1] style lanes
+    regs = []
+    for tok in re.findall(r'[a-z]+[0-9]*', op.lower()):
+        reg = parse_reg(tok)
+        if reg:
+            regs.append(reg)
+    return regs
+
+def defs_uses(ins, operands):
+    """Find the registers an instruction defines/uses, returns
+    (defs, uses), lane-wise/partial writes list the dest as a use too"""
+    base = ins.split('.')[0]
+    ops = split_operands(operands)
+    defs = []
+    uses = []
+
+    # memory operands, writeback defines the base register
+    mem = []
+    writeback = False
+    for i, op in enumerate(ops):
+        if op.startswith('['):
+            mem.append(i)
+            m = re.match(r'\[\s*([a-z0-9]+)', op)
+            if m and (op.endswith('!') or i+1 < len(ops)):
+                writeback = parse_reg(m.group(1))
+
+    # branches
+    if base in {'b', 'bx', 'blx', 'bl'}:
+        if base in {'bl', 'blx'}:
+            defs.append('lr')
+        for op in ops:
+            uses.extend(r for r in operand_regs(op) if r != 'pc')
+        return defs, uses
+    if base in {'cbz', 'cbnz'}:
+        return [], operand_regs(ops[0])
+    if re.match(r'b(%s)$' % CONDS, base):
+        return [], ['flags']
+    if base in {'le', 'letp', 'lctp'}:
+        return ['lr'], ['lr'] + (['vpr'] if base == 'letp' else [])
+    if base in {'dls', 'wls', 'dlstp', 'wlstp'}:
+        return ['lr'], operand_regs(ops[1]) if len(ops) > 1 else []
+    if re.match(r'it[te]*$', base):
+        return [], ['flags']
+    if re.match(r'vpst[te]*$', base):
+        return [], ['vpr']
+    if re.match(r'vpt[te]*$', base) or base in {'vcmp', 'vctp', 'vmsr'}:
+        uses = []
+        for op in ops:
+            uses.extend(r for r in operand_regs(op) if r != 'vpr')
+        return ['vpr'], uses
+    if base in {'cmp', 'cmn', 'tst', 'teq'}:
+        for op in ops:
+            uses.extend(operand_regs(op))
+        return ['flags'], uses
+
+    # register lists
+    if base in {'push', 'vpush', 'stm', 'stmia', 'stmdb', 'vstm', 'vstmia',
+            'vstmdb'}:
+        if base in {'push', 'vpush'}:
+            defs.append('sp')
+            uses.append('sp')
+        for op in ops:
+            if op.startswith('{'):
+                uses.extend(parse_reglist(op[1:-1]))
+            else:
+                reg = parse_reg(op.rstrip('!'))
+                uses.append(reg)
+                if op.endswith('!'):
+                    defs.append(reg)
+        return defs, uses
+    if base in {'pop', 'vpop', 'ldm', 'ldmia', 'ldmdb', 'vldm', 'vldmia',
+            'vldmdb'}:
+        if base in {'pop', 'vpop'}:
+            defs.append('sp')
+            uses.append('sp')
+        for op in ops:
+            if op.startswith('{'):
+                defs.extend(parse_reglist(op[1:-1]))
+            else:
+                reg = parse_reg(op.rstrip('!'))
+                uses.append(reg)
+                if op.endswith('!'):
+                    defs.append(reg)
+        return defs, uses
+
+    # stores, everything is a use
+    if re.match(r'(str|vstr|vst[0-9])', base):
+        for op in ops:
+            uses.extend(operand_regs(op))
+        if writeback:
+            defs.append(writeback)
+        return defs, uses
+
+    # loads, dests are everything before the memory operand
+    if re.match(r'(ldr|vldr|vld[0-9]|ldrex)', base):
+        first_mem = mem[0] if mem else len(ops)
+        for op in ops[:first_mem]:
+            defs.extend(operand_regs(op))
+        for op in ops[first_mem:]:
+            uses.extend(r for r in operand_regs(op) if r != 'pc')
+        if writeback:
+            defs.append(writeback)
+        return defs, uses
+
+    # vmov has many forms, leading GPRs are dests if anything else is a
+    # vector register, otherwise leading vector registers are dests
+    if base == 'vmov' and len(ops) > 1:
+        regs = [operand_regs(op) for op in ops]
+        isgpr = [bool(r) and r[0][0] == 'r' for r in regs]
+        if isgpr[0]:
+            n = isgpr.index(False) if False in isgpr else 1
+        else:
+            n = isgpr.index(True) if True in isgpr else 1
+        for op, r in zip(ops[:n], regs[:n]):
+            defs.extend(r)
+            # lane/partial writes also read the old value
+            if '[' in op or re.match(r'[sd][0-9]', op.lower()):
+                uses.extend(r)
+        for r in regs[n:]:
+            uses.extend(r)
+        return defs, uses
+
+    # default, first operand (or two) are dests, rest are uses
+    ndefs = 2 if TWO_DEST.match(base) else 1
+    for op in ops[:ndefs]:
+        defs.extend(operand_regs(op))
+    for op in ops[ndefs:]:
+        uses.extend(operand_regs(op))
+    if (READ_DEST.match(base)
+            or (len(ops) == 2
+                and not base.startswith('v')
+                and not UNARY.match(base))):
+        uses.extend(defs)
+    # vshlc's carry is both read and written
+    if base == 'vshlc':
+        defs.extend(uses)
+    if SET_FLAGS.match(base):
+        defs.append('flags')
+    if base in {'adc', 'adcs', 'sbc', 'sbcs', 'rrx', 'rrxs'}:
+        uses.append('flags')
+    return defs, uses
+
+
+class Ins:
+    __slots__ = ('i', 'pc', 'sym', 'ins', 'operands', 'defs', 'uses',
+        'deps', 'lat', 'start', 'finish', 'crit')
+    def __init__(self, i, pc, sym, ins, operands):
+        self.i = i
+        self.pc = pc
+        self.sym = sym
+        self.ins = ins
+        self.operands = operands
+
+def collect(path, **args):
+    pattern = re.compile(
+        r'=>\s+0x([0-9a-f]+)\s*(?:<([^>]*)>)?:\s+([^\s]+)\s*([^@;]*)')
+    trace = []
+    with open(path) as f:
+        for line in f:
+            m = pattern.match(line)
+            if m:
+                trace.append(Ins(
+                    len(trace),
+                    int(m.group(1), 16),
+                    m.group(2),
+                    m.group(3),
+                    m.group(4).strip()))
+
+    # build dependency graph and ASAP schedule, note IT/VPT blocks turn
+    # writes into read-modify-writes
+    last_def = {}
+    pending_it = 0
+    pending_vpt = 0
+    for ins in trace:
+        defs, uses = defs_uses(ins.ins, ins.operands)
+        defs = [r for r in defs if r and r != 'pc']
+        uses = [r for r in uses if r and r != 'pc']
+        if pending_it:
+            uses.extend(['flags'] + defs)
+            pending_it -= 1
+        if pending_vpt and ins.ins.startswith('v'):
+            uses.extend(['vpr'] + defs)
+            pending_vpt -= 1
+        m = re.match(r'it([te]*)$', ins.ins)
+        if m:
+            pending_it = 1 + len(m.group(1))
+        m = re.match(r'vp(?:s)?t([te]*)(?:\.|$)', ins.ins)
+        if m:
+            pending_vpt = 1 + len(m.group(1))
+
+        ins.defs = set(defs)
+        ins.uses = set(uses)
+        ins.deps = {last_def[r] for r in ins.uses if r in last_def}
+        ins.lat = 1
+        if args.get('latency'):
+            for pattern_, lat in LATENCIES.values():
+                if re.match(pattern_ + '$', ins.ins):
+                    ins.lat = lat
+                    break
+        ins.start = max((trace[d].finish for d in ins.deps), default=0)
+        ins.finish = ins.start + ins.lat
+        ins.crit = max(ins.deps, key=lambda d: trace[d].finish, default=None)
+        for r in ins.defs:
+            last_def[r] = ins.i
+
+    return trace
+
+def find_loop(trace, **args):
+    # find the hottest backwards branch target, or use an explicit one
+    if args.get('loop'):
+        head = int(args['loop'], 0)
+    else:
+        targets = co.Counter()
+        for a, b in zip(trace, trace[1:]):
+            if b.pc < a.pc:
+                targets[b.pc] += 1
+        if not targets:
+            return None, []
+        head, _ = max(targets.items(), key=lambda p: (p[1], -p[0]))
+
+    starts = [ins.i for ins in trace if ins.pc == head]
+    # loop body is everything between consecutive visits of the head
+    iters = [(a, b) for a, b in zip(starts, starts[1:])]
+    return head, iters
+
+def chains(trace, lo, hi, n):
+    # longest dependent chains within one iteration, ignoring anything
+    # carried in from the previous iteration
+    depth = {}
+    prev = {}
+    for ins in trace[lo:hi]:
+        best = None
+        for d in ins.deps:
+            if lo <= d < hi and (best is None or depth[d] > depth[best]):
+                best = d
+        depth[ins.i] = (depth[best] if best is not None else 0) + ins.lat
+        prev[ins.i] = best
+
+    # walk back from the deepest ends, skipping ends already covered
+    covered = set()
+    results = []
+    for end in sorted(depth, key=lambda i: (-depth[i], i)):
+        if end in covered:
+            continue
+        chain = []
+        i = end
+        while i is not None:
+            chain.append(i)
+            i = prev[i]
+        chain.reverse()
+        covered.update(chain)
+        results.append((depth[end], chain))
+        if len(results) >= n:
+            break
+    return results
+
+def carried(trace, lo, hi):
+    # follow the critical predecessors back from the latest instruction
+    # of the iteration until we leave it, this is the loop-carried chain
+    end = max(range(lo, hi), key=lambda i: (trace[i].finish, i))
+    chain = []
+    i = end
+    while i is not None and i >= lo:
+        chain.append(i)
+        i = trace[i].crit
+    chain.reverse()
+    return chain
+
+def fmt_chain(trace, chain):
+    return ' -> '.join(trace[i].ins for i in chain)
+
+def main(paths, **args):
+    for path in paths:
+        trace = collect(path, **args)
+        if not trace:
+            print('%s: no instructions found?' % path)
+            continue
+        crit = max(ins.finish for ins in trace)
+        print('%-42s %7s %7s %7s' % ('', 'ins', 'crit', 'ilp'))
+        print('%-42s %7d %7d %7.2f' % (
+            re.sub(r'\.trace$', '', path),
+            len(trace),
+            crit,
+            len(trace) / crit))
+
+        head, iters = find_loop(trace, **args)
+        if len(iters) < 2:
+            print()
+            continue
+        # skip the first/last iterations, these are usually warming up
+        # or exiting
+        steady = iters[1:-1] if len(iters) > 2 else iters
+        ins_per = sum(hi-lo for lo, hi in steady) / len(steady)
+        ends = [max(trace[i].finish for i in range(lo, hi))
+            for lo, hi in iters]
+        carried_per = (ends[-2] - ends[0]) / max(len(iters)-2, 1)
+        latency_per = sum(
+            max(d for d, _ in chains(trace, lo, hi, 1))
+            for lo, hi in steady) / len(steady)
+
+        print()
+        print('hottest loop at 0x%x%s, %d iterations' % (
+            head,
+            ' <%s>' % trace[iters[0][0]].sym if trace[iters[0][0]].sym
+                else '',
+            len(iters)))
+        print('%-42s %7.1f' % ('ins/iter', ins_per))
+        print('%-42s %7.1f' % ('critical path/iter (loop-carried)',
+            carried_per))
+        print('%-42s %7.1f' % ('critical path/iter (one iteration)',
+            latency_per))
+        print('%-42s %7.2f' % ('ilp/iter',
+            ins_per / carried_per if carried_per else float('inf')))
+
+        # show chains for a representative iteration
+        lo, hi = steady[len(steady)//2]
+        chain = carried(trace, lo, hi)
+        print()
+        print('loop-carried chain:')
+        print('%7d %s' % (
+            trace[chain[-1]].finish - trace[chain[0]].start,
+            fmt_chain(trace, chain)))
+        print()
+        print('longest chains:')
+        for depth, chain in chains(trace, lo, hi, args.get('chains') or 5):
+            print('%7d %s' % (depth, fmt_chain(trace, chain)))
+        print()
+
+
+if __name__ == "__main__":
+    import argparse
+    import sys
+    parser = argparse.ArgumentParser(
+        description="Find the critical path and ILP in executed traces.")
+    parser.add_argument('paths', nargs='+',
+        help="Trace files to analyze.")
+    parser.add_argument('-l', '--latency', action='store_true',
+        help="Use rough per-instruction latencies instead of 1.")
+    parser.add_argument('-L', '--loop',
+        help="Address of the loop head to analyze, defaults to the "
+            "hottest backwards branch target.")
+    parser.add_argument('-n', '--chains', type=int,
+        help="Number of chains to show, defaults to 5.")
+    sys.exit(main(**vars(parser.parse_args())))
@@ -1,8 +1,18 @@
 
 #include <stdio.h>
 #include <inttypes.h>
+#include <string.h>
 
+#ifdef __ARM_FEATURE_MVE
 #include <arm_mve.h>
+#endif
+
+#include "patch.h"
+#include "pipeline.h"
+#include "prefix.h"
+#include "record.h"
+#include "rolling.h"
+#include "syndrome.h"
 
 
 // crc32c implementations
@@ -13,7 +23,14 @@ struct impl {
 
 extern struct impl impls[];
 
-#if defined(DATA_SMALL)
+// reference implementation
+extern uint32_t crc32c_naive(uint32_t crc, const void *data, size_t size);
+
+#if defined(DATA_SIZE)
+// arbitrary sizes are checked against crc32c_naive at runtime
+#define DATA_SEED 1
+#define DATA_CRC crc32c_naive(0, data, DATA_SIZE)
+#elif defined(DATA_SMALL)
 #define DATA_SIZE 512
 #define DATA_SEED 1
 #define DATA_CRC 0x9f2076a7
@@ -26,6 +43,62 @@ extern struct impl impls[];
 __attribute__((aligned(4096)))
 uint8_t data[DATA_SIZE];
 
+// baseline for the pipeline comparison
+extern uint32_t crc32c_folding_vmullp16_8x16wide(
+        uint32_t crc, const void *data, size_t size);
+
+// dual crc32+crc32c kernel
+extern void crc32_crc32c(uint32_t *crc32, uint32_t *crc32c,
+        const void *data, size_t size);
+
+// reference crc32 (0x04c11db7), for checking crc32_crc32c
+uint32_t crc32_naive(uint32_t crc, const void *data, size_t size) {
+    const uint8_t *data_ = data;
+    crc = crc ^ 0xffffffff;
+    for (size_t i = 0; i < size; i++) {
+        crc = crc ^ data_[i];
+        for (size_t j = 0; j < 8; j++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+        }
+    }
+    return crc ^ 0xffffffff;
+}
+
+// optional timer, bare-metal targets provide a real one
+__attribute__((weak))
+uint32_t ticks(void) {
+    return 0;
+}
+
+// crc16/crc8 kernels
+extern uint16_t crc16_arc_folding_vmullp16(
+        uint16_t crc, const void *data, size_t size);
+extern uint16_t crc16_kermit_folding_vmullp16(
+        uint16_t crc, const void *data, size_t size);
+extern uint8_t crc8_maxim_folding_vmullp8(
+        uint8_t crc, const void *data, size_t size);
+
+// reference bit-reflected crcs of any width <= 32, with no init/final
+// xor, for checking the crc16/crc8 kernels
+uint32_t crcn_naive(uint32_t polynomial_r,
+        uint32_t crc, const void *data, size_t size) {
+    const uint8_t *data_ = data;
+    for (size_t i = 0; i < size; i++) {
+        crc = crc ^ data_[i];
+        for (size_t j = 0; j < 8; j++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? polynomial_r : 0);
+        }
+    }
+    return crc;
+}
+
+// crc32c_record_replay callback, chains the crc32c of every payload
+int record_replayed(void *ctx, const void *payload, size_t size) {
+    uint32_t *crc = ctx;
+    *crc = crc32c_naive(*crc, payload, size);
+    return 0;
+}
+
 uint32_t xorshift32(uint32_t *state) {
     uint32_t x = *state;
     x ^= x << 13;
@@ -35,6 +108,15 @@ uint32_t xorshift32(uint32_t *state) {
     return x;
 }
 
+void result(const char *name, uint32_t crc, uint32_t expected, uint32_t t) {
+    printf("%-42s => 0x%08"PRIx32"%s", name, crc,
+            (crc == expected) ? "" : " !");
+    if (t) {
+        printf(" %9"PRIu32" ticks", t);
+    }
+    printf("\n");
+}
+
 int main(void) {
     // create some random data
     uint32_t state = DATA_SEED;
@@ -44,8 +126,183 @@ int main(void) {
 
     // run crcs
     for (size_t i = 0; impls[i].name; i++) {
+        uint32_t t = ticks();
         uint32_t crc = impls[i].crc32c(0, data, DATA_SIZE);
-        printf("%-42s => 0x%08"PRIx32"%s\n", impls[i].name, crc,
-                (crc == DATA_CRC) ? "" : " !");
+        t = ticks() - t;
+        result(impls[i].name, crc, DATA_CRC, t);
+    }
+
+    // everything else needs MVE, non-MVE builds (make cpus) only have
+    // the portable kernels
+#ifdef __ARM_FEATURE_MVE
+    // the crc32 half of the dual kernel, crc32c is checked above
+    {
+        uint32_t crc32 = 0;
+        uint32_t crc32c = 0;
+        uint32_t t = ticks();
+        crc32_crc32c(&crc32, &crc32c, data, DATA_SIZE);
+        t = ticks() - t;
+        result("crc32_crc32c (crc32)", crc32,
+                crc32_naive(0, data, DATA_SIZE), t);
+    }
+
+    // crc16/crc8 kernels
+    {
+        uint32_t t = ticks();
+        uint16_t crc = crc16_arc_folding_vmullp16(0, data, DATA_SIZE);
+        t = ticks() - t;
+        result("crc16_arc_folding_vmullp16", crc,
+                crcn_naive(0xa001, 0, data, DATA_SIZE), t);
+    }
+
+    {
+        uint32_t t = ticks();
+        uint16_t crc = crc16_kermit_folding_vmullp16(0, data, DATA_SIZE);
+        t = ticks() - t;
+        result("crc16_kermit_folding_vmullp16", crc,
+                crcn_naive(0x8408, 0, data, DATA_SIZE), t);
     }
+
+    {
+        uint32_t t = ticks();
+        uint8_t crc = crc8_maxim_folding_vmullp8(0, data, DATA_SIZE);
+        t = ticks() - t;
+        result("crc8_maxim_folding_vmullp8", crc,
+                crcn_naive(0x8c, 0, data, DATA_SIZE), t);
+    }
+
+    // simulate a DMA-fed transfer, chunks land in a double-buffered ring
+    // and are folded as they arrive, the latency that matters is from the
+    // last chunk landing to having a crc32c
+    {
+        static uint8_t ring[2][256];
+        static struct crc32c_pipeline p;
+        crc32c_pipeline_init(&p, 0);
+
+        uint32_t t = 0;
+        for (size_t i = 0; i < DATA_SIZE; i += sizeof(ring[0])) {
+            size_t n = (DATA_SIZE-i < sizeof(ring[0]))
+                    ? DATA_SIZE-i
+                    : sizeof(ring[0]);
+            // "DMA" into the next slot
+            uint8_t *slot = ring[(i / sizeof(ring[0])) % 2];
+            memcpy(slot, &data[i], n);
+
+            t = ticks();
+            crc32c_pipeline_submit(&p, slot, n);
+        }
+        uint32_t crc = crc32c_pipeline_finish(&p);
+        t = ticks() - t;
+        result("crc32c_pipeline (after last chunk)", crc, DATA_CRC, t);
+
+        // compared to receiving everything, then calling crc32c
+        t = ticks();
+        crc = crc32c_folding_vmullp16_8x16wide(0, data, DATA_SIZE);
+        t = ticks() - t;
+        result("crc32c (after everything)", crc, DATA_CRC, t);
+    }
+
+    // treat the first 24 bytes as a fixed header, the rest should resume
+    // from the saved state
+    {
+        static struct crc32c_prefix prefix;
+        size_t n = (DATA_SIZE < 24) ? DATA_SIZE : 24;
+        crc32c_prefix_init(&prefix, 0, data, n);
+
+        uint32_t t = ticks();
+        uint32_t crc = crc32c_prefix_resume(&prefix,
+                &data[n], DATA_SIZE-n);
+        t = ticks() - t;
+        result("crc32c_prefix", crc, DATA_CRC, t);
+    }
+
+    // patch a small range in the middle, this should match a full
+    // recompute
+    {
+        size_t off = DATA_SIZE/3;
+        size_t n = (DATA_SIZE/3 < 16) ? DATA_SIZE/3 : 16;
+        uint32_t old_crc = DATA_CRC;
+        uint8_t old[16];
+        memcpy(old, &data[off], n);
+        for (size_t i = 0; i < n; i++) {
+            data[off+i] ^= (uint8_t)xorshift32(&state);
+        }
+
+        uint32_t t = ticks();
+        uint32_t crc = 0;
+        crc32c_patch(&crc, old_crc, DATA_SIZE, off, old, &data[off], n);
+        t = ticks() - t;
+        result("crc32c_patch", crc, crc32c_naive(0, data, DATA_SIZE), t);
+
+        memcpy(&data[off], old, n);
+    }
+
+    // roll a window across the data, this should match the crc32c of
+    // the last window
+    {
+        static struct crc32c_rolling r;
+        size_t window = (DATA_SIZE < 48) ? DATA_SIZE : 48;
+        crc32c_rolling_init(&r, window);
+        crc32c_rolling_start(&r, data);
+
+        uint32_t t = ticks();
+        for (size_t i = window; i < DATA_SIZE; i++) {
+            crc32c_rolling_roll(&r, data[i-window], data[i]);
+        }
+        t = ticks() - t;
+        result("crc32c_rolling", crc32c_rolling_crc(&r),
+                crc32c_naive(0, &data[DATA_SIZE-window], window), t);
+    }
+
+    // flip a bit, this should be found and corrected
+    {
+        static struct crc32c_syndrome s;
+        crc32c_syndrome_init(&s);
+
+        uint32_t expected = DATA_CRC;
+        uint32_t crc = expected;
+        size_t bit = (8*DATA_SIZE) / 3;
+        data[bit/8] ^= 1 << (bit%8);
+
+        uint32_t t = ticks();
+        crc32c_syndrome_correct(&s, data, DATA_SIZE, &crc, NULL);
+        t = ticks() - t;
+        result("crc32c_syndrome", crc32c_naive(0, data, DATA_SIZE),
+                expected, t);
+    }
+
+    // write data as a log of 32-128 byte records, corrupt one, and replay
+    // up to it
+    {
+        static uint8_t buffer[DATA_SIZE
+                + CRC32C_RECORD_OVERHEAD*(DATA_SIZE/32+1)];
+        static struct crc32c_record_log log;
+        crc32c_record_init(&log, buffer, sizeof(buffer));
+
+        uint32_t state = DATA_SEED;
+        size_t bad = 0;
+        size_t bad_off = 0;
+        for (size_t i = 0; i < DATA_SIZE;) {
+            size_t n = 32 + xorshift32(&state) % 97;
+            n = (n < DATA_SIZE-i) ? n : DATA_SIZE-i;
+            // corrupt the record containing the middle of data
+            if (i <= DATA_SIZE/2) {
+                bad = i;
+                bad_off = log.off;
+            }
+            crc32c_record_begin(&log, n);
+            crc32c_record_append(&log, &data[i], n/2);
+            crc32c_record_append(&log, &data[i+n/2], n-n/2);
+            crc32c_record_end(&log);
+            i += n;
+        }
+        buffer[bad_off+2] ^= 0x01;
+
+        uint32_t crc = 0;
+        uint32_t t = ticks();
+        crc32c_record_replay(buffer, log.off, record_replayed, &crc);
+        t = ticks() - t;
+        result("crc32c_record", crc, crc32c_naive(0, data, bad), t);
+    }
+#endif
 }
@@ -0,0 +1,96 @@
+// Incremental crc32c updates after modifying a range of bytes in place,
+// using MVE's vmull.p16 for the polynomial multiplications
+
+#include "patch.h"
+
+#include <string.h>
+
+#include <arm_mve.h>
+
+
+static inline uint64_t pmul32(uint32_t a, uint32_t b) {
+    uint16x8_t a_v = __arm_vdupq_n_u16(a);
+    uint16x8_t b_v = __arm_vdupq_n_u16(b);
+    a_v = (uint16x8_t)__arm_vsetq_lane_u32(a, (uint32x4_t)a_v, 1);
+    a_v = (uint16x8_t)__arm_vsetq_lane_u32(a, (uint32x4_t)a_v, 3);
+    b_v = (uint16x8_t)__arm_vsetq_lane_u32(b, (uint32x4_t)b_v, 2);
+    b_v = (uint16x8_t)__arm_vsetq_lane_u32(b, (uint32x4_t)b_v, 3);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(a_v, b_v);
+
+    return ((uint64_t)__arm_vgetq_lane_u32(x_v, 0))
+         ^ ((uint64_t)__arm_vgetq_lane_u32(x_v, 1) << 16)
+         ^ ((uint64_t)__arm_vgetq_lane_u32(x_v, 2) << 16)
+         ^ ((uint64_t)__arm_vgetq_lane_u32(x_v, 3) << 32);
+}
+
+static inline uint32_t reduce8(uint32_t crc, uint8_t d) {
+    // Barret reduce bytes
+    crc = crc ^ d;
+    uint32_t b = (uint32_t)pmul32(crc << 24, 0xdea713f1);
+    return (crc >> 8)
+            ^ (uint32_t)(pmul32(b, 0x05ec76f1) >> 32)
+            ^ b;
+}
+
+static inline uint32_t reduce32(uint32_t crc, uint32_t d) {
+    // Barret reduce 32-bit words
+    uint32_t b = (uint32_t)pmul32(crc ^ d, 0xdea713f1);
+    return (uint32_t)(pmul32(b, 0x05ec76f1) >> 32) ^ b;
+}
+
+uint32_t crc32c_mulmod(uint32_t a, uint32_t b) {
+    // a reflected pmul leaves the product 1 bit short of 64-bits, and
+    // reducing the upper word is the same as a Barret reduction with
+    // 32-bits of zeros
+    uint64_t x = pmul32(a, b) << 1;
+    return (uint32_t)(x >> 32) ^ reduce32((uint32_t)x, 0);
+}
+
+uint32_t crc32c_xpow(uint64_t n) {
+    // square-and-multiply, note 1 is 0x80000000 and x is 0x40000000 when
+    // bit-reflected
+    uint32_t x = 0x80000000;
+    uint32_t p = 0x40000000;
+    while (n) {
+        if (n & 1) {
+            x = crc32c_mulmod(x, p);
+        }
+        p = crc32c_mulmod(p, p);
+        n >>= 1;
+    }
+    return x;
+}
+
+int crc32c_patch(uint32_t *crc_, uint32_t old_crc,
+        size_t total_len, size_t offset,
+        const void *old_bytes, const void *new_bytes, size_t n) {
+    const uint8_t *old_ = old_bytes;
+    const uint8_t *new_ = new_bytes;
+
+    // out of range, this would underflow the trailing byte count
+    if (offset > total_len || n > total_len - offset) {
+        return CRC32C_PATCH_INVALID;
+    }
+
+    // crc the xor delta, with no init/final xor, leading zeros don't
+    // change anything so we can skip the first offset bytes
+    uint32_t crc = 0;
+    size_t i = 0;
+    for (; i+4 <= n; i += 4) {
+        uint32_t a;
+        uint32_t b;
+        memcpy(&a, &old_[i], sizeof(a));
+        memcpy(&b, &new_[i], sizeof(b));
+        crc = reduce32(crc, a ^ b);
+    }
+    for (; i < n; i++) {
+        crc = reduce8(crc, old_[i] ^ new_[i]);
+    }
+
+    // shift by the trailing bytes, which are also zero in the delta
+    crc = crc32c_mulmod(crc, crc32c_xpow(8*(uint64_t)(total_len-offset-n)));
+
+    *crc_ = old_crc ^ crc;
+    return CRC32C_PATCH_OK;
+}
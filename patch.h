@@ -0,0 +1,37 @@
+// Incremental crc32c updates after modifying a range of bytes in place
+//
+// CRCs are linear, so the new CRC is just the old CRC xored with the CRC
+// of the xor delta. We only need to CRC the changed bytes, and shift the
+// result by the number of trailing bytes with a multiply by x^(8*n) mod P.
+
+#ifndef PATCH_H
+#define PATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+// crc32c_patch errors
+enum {
+    CRC32C_PATCH_OK      = 0,
+    CRC32C_PATCH_INVALID = -1,
+};
+
+// Find the crc32c of a total_len message after bytes [offset, offset+n)
+// change from old_bytes to new_bytes, given the crc32c of the original
+// message, old_crc, the new crc32c is written to crc
+//
+// offset+n must be <= total_len, otherwise CRC32C_PATCH_INVALID is
+// returned and crc is left alone
+int crc32c_patch(uint32_t *crc, uint32_t old_crc,
+        size_t total_len, size_t offset,
+        const void *old_bytes, const void *new_bytes, size_t n);
+
+// Returns x^n mod P, bit-reflected, this is useful for shifting a crc32c
+// by n zero bits
+uint32_t crc32c_xpow(uint64_t n);
+
+// Returns a*b mod P, with a and b bit-reflected
+uint32_t crc32c_mulmod(uint32_t a, uint32_t b);
+
+#endif
@@ -0,0 +1,175 @@
+// A streaming crc32c for DMA-fed data, using polynomial folding leveraging
+// ARMv8-M's MVE vmull.p16 instruction, 8 16-bit halfwords at a time
+
+#include "pipeline.h"
+
+#include <string.h>
+
+#include <arm_mve.h>
+
+
+// x^(-8n-1) mod P for n = 1..16 zero bytes, bit-reflected, see
+// ./constants.py
+static const uint32_t UNSHIFT[16] = {
+    0xfe2b5c35, 0x780d5a4d, 0xbf818109, 0xa9cdda0d,
+    0xa738873b, 0x616f3095, 0xa9a3f760, 0xc915ea3b,
+    0xbc77a5aa, 0x51dde21e, 0xf838cd50, 0x77f5096b,
+    0x71345056, 0xac045b70, 0x7ce4570e, 0x413d19cd,
+};
+
+
+static inline uint32_t pmul32(uint32_t a, uint32_t b) {
+    uint16x8_t a_v = __arm_vdupq_n_u16(a);
+    uint16x8_t b_v = __arm_vdupq_n_u16(b);
+    a_v = (uint16x8_t)__arm_vsetq_lane_u32(a, (uint32x4_t)a_v, 1);
+    b_v = (uint16x8_t)__arm_vsetq_lane_u32(b, (uint32x4_t)b_v, 2);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(a_v, b_v);
+
+    return __arm_vgetq_lane_u32(x_v, 0)
+            ^ (__arm_vgetq_lane_u32(x_v, 1) << 16)
+            ^ (__arm_vgetq_lane_u32(x_v, 2) << 16);
+}
+
+// upper 32-bits of a 32x32 pmul, hi*hi ^ (hi*lo ^ lo*hi) >> 16
+static inline uint32_t pmul32_hi(uint32_t a, uint32_t b) {
+    uint32x4_t a_v = __arm_vdupq_n_u32(a);
+    uint32x4_t b_v = __arm_vdupq_n_u32(b);
+    a_v = __arm_vsetq_lane_u32(a << 16, a_v, 2);
+    b_v = __arm_vsetq_lane_u32(b << 16, b_v, 1);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)a_v, (uint16x8_t)b_v);
+
+    return __arm_vgetq_lane_u32(x_v, 0)
+            ^ (__arm_vgetq_lane_u32(x_v, 1) >> 16)
+            ^ (__arm_vgetq_lane_u32(x_v, 2) >> 16);
+}
+
+static inline uint32x4_t reduce8(uint32x4_t folded_v, uint8_t d) {
+    // Barret reduce 8-bit bytes
+    uint32_t crc = __arm_vgetq_lane_u32(folded_v, 0) ^ d;
+    uint32_t b = pmul32(crc << 24, 0xdea713f1);
+    crc = (crc >> 8) ^ pmul32_hi(b, 0x05ec76f1) ^ b;
+    return __arm_vsetq_lane_u32(crc, folded_v, 0);
+}
+
+static inline uint32x4_t reduce32(
+        uint32x4_t folded_v, uint32_t *overflow, uint32_t d) {
+    // Barret reduce 32-bit words
+    uint32_t crc = __arm_vgetq_lane_u32(folded_v, 0) ^ d;
+    uint32_t b = pmul32(crc, 0xdea713f1);
+    crc = __arm_vgetq_lane_u32(folded_v, 1) ^ pmul32_hi(b, 0x05ec76f1) ^ b;
+    folded_v = __arm_vsetq_lane_u32(crc, folded_v, 0);
+    folded_v = __arm_vsetq_lane_u32(
+            __arm_vgetq_lane_u32(folded_v, 2), folded_v, 1);
+    folded_v = __arm_vsetq_lane_u32(
+            __arm_vgetq_lane_u32(folded_v, 3), folded_v, 2);
+    folded_v = __arm_vsetq_lane_u32(*overflow, folded_v, 3);
+    *overflow = 0;
+    return folded_v;
+}
+
+static inline uint32x4_t fold128(
+        uint32x4_t folded_v, uint32_t *overflow,
+        const uint8_t *data) {
+    uint32x4_t k_lower_v = __arm_vdupq_n_u32(0x55460dfe);
+    uint32x4_t k_upper_v = __arm_vdupq_n_u32(0x5407f20c);
+
+    // xor data into folded, vldrb doesn't care about alignment
+    folded_v = __arm_veorq_u32(folded_v,
+            (uint32x4_t)__arm_vld1q_u8(data));
+    // 2x p16xp32 -> p48 folds
+    uint32x4_t lower0_v = __arm_vmullbq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_lower_v);
+    uint32x4_t lower1_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_lower_v);
+    uint32x4_t upper0_v = __arm_vmullbq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_upper_v);
+    uint32x4_t upper1_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_upper_v);
+    // xor/shift into folded
+    uint32x4_t lower_v = __arm_veorq_u32(lower0_v, lower1_v);
+    uint32x4_t upper_v = __arm_veorq_u32(upper0_v, upper1_v);
+    return __arm_veorq_u32(lower_v,
+            __arm_vshlcq_u32(upper_v, overflow, 16));
+}
+
+void crc32c_pipeline_init(struct crc32c_pipeline *p, uint32_t crc) {
+    memset(p, 0, sizeof(*p));
+    p->folded[0] = crc ^ 0xffffffff;
+}
+
+void crc32c_pipeline_submit(struct crc32c_pipeline *p,
+        const void *data, size_t size) {
+    const uint8_t *data_ = data;
+    uint32x4_t folded_v = __arm_vld1q_u32(p->folded);
+    uint32_t overflow = p->overflow;
+
+    // finish any staged block first, but only fold if at least 16 bytes
+    // will be left over
+    while (p->staged_size > 0 && p->staged_size + size >= 32) {
+        if (p->staged_size < 16) {
+            size_t n = 16 - p->staged_size;
+            memcpy(&p->staged[p->staged_size], data_, n);
+            p->staged_size += n;
+            data_ += n;
+            size -= n;
+        }
+
+        folded_v = fold128(folded_v, &overflow, p->staged);
+        memmove(p->staged, &p->staged[16], p->staged_size-16);
+        p->staged_size -= 16;
+    }
+
+    // fold directly from the buffer, holding back 16-31 bytes
+    if (p->staged_size == 0) {
+        for (; size >= 32; data_ += 16, size -= 16) {
+            folded_v = fold128(folded_v, &overflow, data_);
+        }
+    }
+
+    // stage whatever is left, this always fits
+    memcpy(&p->staged[p->staged_size], data_, size);
+    p->staged_size += size;
+
+    __arm_vst1q_u32(p->folded, folded_v);
+    p->overflow = overflow;
+}
+
+uint32_t crc32c_pipeline_finish(const struct crc32c_pipeline *p) {
+    uint32x4_t folded_v = __arm_vld1q_u32(p->folded);
+    uint32_t overflow = p->overflow;
+
+    // if we've folded anything, we need at least 16 bytes to shift out the
+    // folded state, so pad short tails with zeros, and shift the zeros back
+    // out with a multiply by x^-8n mod P, one Barret step
+    if (p->staged_size < 16) {
+        uint8_t staged[16] = {0};
+        memcpy(staged, p->staged, p->staged_size);
+        for (size_t i = 0; i < 16; i += 4) {
+            uint32_t d;
+            memcpy(&d, &staged[i], sizeof(d));
+            folded_v = reduce32(folded_v, &overflow, d);
+        }
+
+        uint32_t crc = __arm_vgetq_lane_u32(folded_v, 0);
+        uint32_t k = UNSHIFT[16-1 - p->staged_size];
+        folded_v = __arm_vsetq_lane_u32(pmul32(crc, k), folded_v, 0);
+        folded_v = __arm_vsetq_lane_u32(pmul32_hi(crc, k), folded_v, 1);
+        folded_v = reduce32(folded_v, &overflow, 0);
+        return __arm_vgetq_lane_u32(folded_v, 0) ^ 0xffffffff;
+    }
+
+    size_t i = 0;
+    for (; i+4 <= p->staged_size; i += 4) {
+        uint32_t d;
+        memcpy(&d, &p->staged[i], sizeof(d));
+        folded_v = reduce32(folded_v, &overflow, d);
+    }
+    for (; i < p->staged_size; i++) {
+        folded_v = reduce8(folded_v, p->staged[i]);
+    }
+
+    return __arm_vgetq_lane_u32(folded_v, 0) ^ 0xffffffff;
+}
@@ -0,0 +1,41 @@
+// A streaming crc32c for DMA-fed data, buffers are folded as they arrive
+//
+// This uses the same vector state as crc32c_folding_vmullp16_8x16wide, but
+// holds back the last 16-31 bytes in a staging buffer instead of folding
+// them, so there is always at least a full block left to reduce. This
+// means crc32c_pipeline_finish takes a constant time, at most 7 words and
+// 3 bytes of Barret reduction, no matter how big the transfer was.
+//
+// A state can also be folded right up to the next byte, as crc32c_prefix
+// does, finish pads tails shorter than a block with zeros and shifts them
+// back out with one multiply by x^-8n mod P.
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+struct crc32c_pipeline {
+    // folded state, a uint32x4_t, plus the 16-bit overflow
+    uint32_t folded[4];
+    uint32_t overflow;
+    // bytes held back from folding
+    size_t staged_size;
+    uint8_t staged[32];
+};
+
+// Start a new crc32c, crc is the crc32c of any previous data, usually 0
+void crc32c_pipeline_init(struct crc32c_pipeline *p, uint32_t crc);
+
+// Fold a buffer into the crc32c, buffers can be any size/alignment, and
+// the buffer can be reused as soon as this returns
+void crc32c_pipeline_submit(struct crc32c_pipeline *p,
+        const void *data, size_t size);
+
+// Reduce any held back bytes and return the final crc32c, this takes a
+// constant time
+uint32_t crc32c_pipeline_finish(const struct crc32c_pipeline *p);
+
+#endif
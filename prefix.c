@@ -0,0 +1,90 @@
+// A crc32c for messages that share a fixed prefix, the prefix is folded
+// into crc32c_pipeline's vector state using MVE's vmull.p16 instruction
+
+#include "prefix.h"
+
+#include <string.h>
+
+#include <arm_mve.h>
+
+
+static inline uint32x4_t fold128(
+        uint32x4_t folded_v, uint32_t *overflow,
+        const uint8_t *data) {
+    uint32x4_t k_lower_v = __arm_vdupq_n_u32(0x55460dfe);
+    uint32x4_t k_upper_v = __arm_vdupq_n_u32(0x5407f20c);
+
+    // xor data into folded, vldrb doesn't care about alignment
+    folded_v = __arm_veorq_u32(folded_v,
+            (uint32x4_t)__arm_vld1q_u8(data));
+    // 2x p16xp32 -> p48 folds
+    uint32x4_t lower0_v = __arm_vmullbq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_lower_v);
+    uint32x4_t lower1_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_lower_v);
+    uint32x4_t upper0_v = __arm_vmullbq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_upper_v);
+    uint32x4_t upper1_v = __arm_vmulltq_poly_p16(
+            (uint16x8_t)folded_v, (uint16x8_t)k_upper_v);
+    // xor/shift into folded
+    uint32x4_t lower_v = __arm_veorq_u32(lower0_v, lower1_v);
+    uint32x4_t upper_v = __arm_veorq_u32(upper0_v, upper1_v);
+    return __arm_veorq_u32(lower_v,
+            __arm_vshlcq_u32(upper_v, overflow, 16));
+}
+
+void crc32c_prefix_init(struct crc32c_prefix *prefix,
+        uint32_t crc, const void *data, size_t size) {
+    const uint8_t *data_ = data;
+    crc32c_pipeline_init(&prefix->pipeline, crc);
+    if (size == 0) {
+        return;
+    }
+
+    // zero-extend the front of the prefix to a multiple of 16 bytes,
+    // leading zeros don't change anything as long as the init xor lands
+    // where the real prefix starts
+    size_t head = (size % 16) ? size % 16 : 16;
+    uint8_t block[16] = {0};
+    memcpy(&block[16-head], data_, head);
+    data_ += head;
+    size -= head;
+
+    uint32_t init = prefix->pipeline.folded[0];
+    for (size_t i = 0; i < 4 && i < head; i++) {
+        block[16-head+i] ^= init >> (8*i);
+    }
+
+    uint32x4_t folded_v = __arm_vdupq_n_u32(0);
+    uint32_t overflow = 0;
+    folded_v = fold128(folded_v, &overflow, block);
+
+    // if the prefix is shorter than the init xor, the rest lands in the
+    // next block, which is the same as xoring it into the folded state
+    if (head < 4) {
+        folded_v = __arm_veorq_u32(folded_v,
+                __arm_vsetq_lane_u32(init >> (8*head),
+                    __arm_vdupq_n_u32(0), 0));
+    }
+
+    // fold everything, nothing is held back
+    for (; size >= 16; data_ += 16, size -= 16) {
+        folded_v = fold128(folded_v, &overflow, data_);
+    }
+
+    __arm_vst1q_u32(prefix->pipeline.folded, folded_v);
+    prefix->pipeline.overflow = overflow;
+}
+
+void crc32c_prefix_start(const struct crc32c_prefix *prefix,
+        struct crc32c_pipeline *p) {
+    *p = prefix->pipeline;
+}
+
+uint32_t crc32c_prefix_resume(const struct crc32c_prefix *prefix,
+        const void *data, size_t size) {
+    struct crc32c_pipeline p;
+    crc32c_prefix_start(prefix, &p);
+    crc32c_pipeline_submit(&p, data, size);
+    return crc32c_pipeline_finish(&p);
+}
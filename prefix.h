@@ -0,0 +1,38 @@
+// A crc32c for messages that share a fixed prefix, the prefix is folded
+// once and each message resumes from the saved state
+//
+// The prefix is zero-extended at the front to a multiple of 16 bytes and
+// folded in full, so the saved state is just crc32c_pipeline's un-reduced
+// vector state with nothing held back. Resuming continues the fold where
+// the prefix left off, the prefix is never Barret reduced on its own, and
+// since the pipeline's loads don't care about alignment there's no
+// per-message alignment head either.
+
+#ifndef PREFIX_H
+#define PREFIX_H
+
+#include "pipeline.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+struct crc32c_prefix {
+    // pipeline state after the prefix, staged_size is always 0
+    struct crc32c_pipeline pipeline;
+};
+
+// Save the state after a prefix, crc is the crc32c of any previous data,
+// usually 0
+void crc32c_prefix_init(struct crc32c_prefix *prefix,
+        uint32_t crc, const void *data, size_t size);
+
+// Start a pipeline from a saved prefix, for messages that arrive in pieces
+void crc32c_prefix_start(const struct crc32c_prefix *prefix,
+        struct crc32c_pipeline *p);
+
+// Return the crc32c of prefix+data, only data is processed
+uint32_t crc32c_prefix_resume(const struct crc32c_prefix *prefix,
+        const void *data, size_t size);
+
+#endif
@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+#
+# Merge the size/count results of make profiles into one table, showing
+# each kernel's code size and instructions under each profile's flags
+#
+# Each profile is a pair of files, <profile>.size from make size, and
+# <profile>.count from make count. The last column is the profile with
+# the fewest instructions for that kernel, which is a good starting point
+# for picking KFLAGS_<kernel>.
+#
+# make cpus reuses this with one profile per cpu.
+#
+
+import os
+import re
+import collections as co
+
+
+def parse_size(path):
+    # berkeley format, text data bss dec hex filename
+    sizes = {}
+    with open(path) as f:
+        for line in f:
+            m = re.match(r'\s*(\d+)\s+\d+\s+\d+\s+\d+\s+[0-9a-f]+\s+(\S+)\.o$',
+                line)
+            if m:
+                sizes[os.path.basename(m.group(2))] = int(m.group(1))
+    return sizes
+
+def parse_count(path):
+    counts = {}
+    with open(path) as f:
+        for line in f:
+            m = re.match(r'(\S+)\s+(\d+)\s', line)
+            if m:
+                counts[m.group(1)] = int(m.group(2))
+    return counts
+
+def main(paths):
+    profiles = co.OrderedDict()
+    for path in paths:
+        name = re.sub(r'^(profile|cpu)-', '', os.path.basename(path))
+        profiles[name] = (
+            parse_size(path + '.size'),
+            parse_count(path + '.count'))
+
+    kernels = sorted(set(k
+        for sizes, counts in profiles.values()
+        for k in list(sizes.keys()) + list(counts.keys())))
+
+    print('%-42s %s %17s' % (
+        '',
+        ' '.join('%17s' % name for name in profiles.keys()),
+        'fastest'))
+    print('%-42s %s %17s' % (
+        '',
+        ' '.join('%7s %9s' % ('code', 'ins') for _ in profiles),
+        ''))
+    for kernel in kernels:
+        fastest = min(
+            ((counts[kernel], name)
+                for name, (_, counts) in profiles.items()
+                if kernel in counts),
+            default=(None, '-'))[1]
+        print('%-42s %s %17s' % (
+            kernel,
+            ' '.join('%7s %9s' % (
+                    sizes.get(kernel, '-'),
+                    counts.get(kernel, '-'))
+                for sizes, counts in profiles.values()),
+            fastest))
+
+
+if __name__ == "__main__":
+    import argparse
+    import sys
+    parser = argparse.ArgumentParser(
+        description="Merge per-profile size/count results into one table.")
+    parser.add_argument('paths', nargs='+',
+        help="Profiles to merge, each reads <path>.size and <path>.count.")
+    sys.exit(main(**vars(parser.parse_args())))
@@ -0,0 +1,154 @@
+// A crc32c framed record log, batches of records are checked with one
+// crc32c_folding_vmullp16_8x16wide call
+
+#include "record.h"
+#include "patch.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+
+extern uint32_t crc32c_folding_vmullp16_8x16wide(
+        uint32_t crc, const void *data, size_t size);
+
+// x^(8*2^i) mod P, bit-reflected, enough for any record size
+static const uint32_t XPOW8[17] = {
+    0x00800000, 0x00008000, 0x82f63b78, 0x6ea2d55c,
+    0x18b8ea18, 0x510ac59a, 0xb82be955, 0xb8fdb1e7,
+    0x88e56f72, 0x74c360a4, 0xe4172b16, 0x0d65762a,
+    0x35d73a62, 0x28461564, 0xbf455269, 0xe2ea32dc,
+    0xfe7740e6,
+};
+
+static inline uint32_t shift(uint32_t crc, size_t size) {
+    // multiply by x^(8*size) mod P, one mulmod per set bit of size
+    for (size_t i = 0; size; i++, size >>= 1) {
+        if (size & 1) {
+            crc = crc32c_mulmod(crc, XPOW8[i]);
+        }
+    }
+    return crc;
+}
+
+void crc32c_record_init(struct crc32c_record_log *log,
+        void *buffer, size_t size) {
+    memset(log, 0, sizeof(*log));
+    log->buffer = buffer;
+    log->size = size;
+}
+
+int crc32c_record_begin(struct crc32c_record_log *log, size_t size) {
+    if (size > CRC32C_RECORD_MAX || log->expected) {
+        return CRC32C_RECORD_INVALID;
+    }
+    if (size + CRC32C_RECORD_OVERHEAD > log->size - log->off) {
+        return CRC32C_RECORD_NOSPACE;
+    }
+
+    uint8_t *header = &log->buffer[log->off];
+    header[0] = (uint8_t)(size >> 0);
+    header[1] = (uint8_t)(size >> 8);
+
+    crc32c_pipeline_init(&log->p, 0);
+    crc32c_pipeline_submit(&log->p, header, 2);
+    // these include the header, so an empty record is still in progress
+    log->appended = 2;
+    log->expected = 2 + size;
+    return CRC32C_RECORD_OK;
+}
+
+int crc32c_record_append(struct crc32c_record_log *log,
+        const void *data, size_t size) {
+    if (size > log->expected - log->appended) {
+        return CRC32C_RECORD_INVALID;
+    }
+
+    memcpy(&log->buffer[log->off + log->appended], data, size);
+    crc32c_pipeline_submit(&log->p, data, size);
+    log->appended += size;
+    return CRC32C_RECORD_OK;
+}
+
+int crc32c_record_end(struct crc32c_record_log *log) {
+    if (!log->expected || log->appended != log->expected) {
+        return CRC32C_RECORD_INVALID;
+    }
+
+    uint32_t crc = crc32c_pipeline_finish(&log->p);
+    uint8_t *trailer = &log->buffer[log->off + log->appended];
+    trailer[0] = (uint8_t)(crc >> 0);
+    trailer[1] = (uint8_t)(crc >> 8);
+    trailer[2] = (uint8_t)(crc >> 16);
+    trailer[3] = (uint8_t)(crc >> 24);
+
+    log->off += log->appended + 4;
+    log->appended = 0;
+    log->expected = 0;
+    return CRC32C_RECORD_OK;
+}
+
+size_t crc32c_record_verify(const void *log, size_t size) {
+    return crc32c_record_replay(log, size, NULL, NULL);
+}
+
+size_t crc32c_record_replay(const void *log, size_t size,
+        int (*cb)(void *ctx, const void *payload, size_t size),
+        void *ctx) {
+    const uint8_t *log_ = log;
+    size_t off = 0;
+    while (true) {
+        // find the next batch of records, a crc32c over the whole batch
+        // starts from where the previous record's residue left it, so
+        // each record adds its residue to a shifted running value
+        size_t ends[CRC32C_RECORD_BATCH];
+        size_t count = 0;
+        size_t end = off;
+        uint32_t expected = 0;
+        while (count < CRC32C_RECORD_BATCH && size - end >= 2) {
+            size_t record = CRC32C_RECORD_OVERHEAD
+                    + (log_[end+0] | (log_[end+1] << 8));
+            if (record > size - end) {
+                break;
+            }
+
+            expected = shift(expected, record)
+                    ^ CRC32C_RECORD_RESIDUE;
+            end += record;
+            ends[count++] = end;
+        }
+
+        if (count == 0) {
+            return off;
+        }
+
+        // check the batch in one call, if this fails find the first bad
+        // record the slow way
+        bool valid = true;
+        if (crc32c_folding_vmullp16_8x16wide(0, &log_[off], end - off)
+                != expected) {
+            size_t start = off;
+            for (size_t i = 0; i < count; i++) {
+                if (crc32c_folding_vmullp16_8x16wide(
+                        0, &log_[start], ends[i] - start)
+                        != CRC32C_RECORD_RESIDUE) {
+                    count = i;
+                    valid = false;
+                    break;
+                }
+                start = ends[i];
+            }
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            if (cb && cb(ctx, &log_[off+2],
+                    ends[i] - off - CRC32C_RECORD_OVERHEAD) != 0) {
+                return off;
+            }
+            off = ends[i];
+        }
+
+        if (!valid) {
+            return off;
+        }
+    }
+}
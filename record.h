@@ -0,0 +1,90 @@
+// A crc32c framed record log, for journals of many small records
+//
+// Each record is a little-endian 16-bit payload size, the payload, and a
+// little-endian crc32c of the size+payload. Appending streams the crc32c
+// through a crc32c_pipeline as the payload arrives.
+//
+// A crc32c over a record including its trailer always gives the same
+// residue, 0x48674bc7, and the crc32c of a run of valid records only
+// depends on their sizes. So replay can check a whole batch of records
+// with one long kernel call, instead of paying the kernel's setup for
+// every 32-128 byte record, and only falls back to checking records one
+// at a time if the batch fails.
+
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "pipeline.h"
+
+
+// largest payload a record can hold
+#define CRC32C_RECORD_MAX 0xffff
+
+// size+crc32c overhead per record
+#define CRC32C_RECORD_OVERHEAD 6
+
+// crc32c of any valid record, including its trailer
+#define CRC32C_RECORD_RESIDUE 0x48674bc7
+
+// records checked per kernel call during replay
+#define CRC32C_RECORD_BATCH 64
+
+struct crc32c_record_log {
+    uint8_t *buffer;
+    size_t size;
+    // end of the last finished record
+    size_t off;
+    // payload bytes appended/expected for the current record, if any
+    size_t appended;
+    size_t expected;
+    struct crc32c_pipeline p;
+};
+
+// crc32c_record_* errors
+enum {
+    CRC32C_RECORD_OK      = 0,
+    CRC32C_RECORD_NOSPACE = -1,
+    CRC32C_RECORD_INVALID = -2,
+};
+
+// Start a log in a buffer, this doesn't look at what's already there
+void crc32c_record_init(struct crc32c_record_log *log,
+        void *buffer, size_t size);
+
+// Start a record with a size byte payload
+//
+// Returns CRC32C_RECORD_NOSPACE if the record won't fit, or
+// CRC32C_RECORD_INVALID if size > CRC32C_RECORD_MAX or a record is
+// already in progress
+int crc32c_record_begin(struct crc32c_record_log *log, size_t size);
+
+// Append part of the current record's payload, this can be called any
+// number of times with any size
+//
+// Returns CRC32C_RECORD_INVALID if this goes past the size passed to
+// crc32c_record_begin
+int crc32c_record_append(struct crc32c_record_log *log,
+        const void *data, size_t size);
+
+// Finish the current record, writing its crc32c
+//
+// Returns CRC32C_RECORD_INVALID if the payload is incomplete
+int crc32c_record_end(struct crc32c_record_log *log);
+
+// Check a log, returns the size of the valid prefix, this stops at the
+// first corrupt or truncated record
+size_t crc32c_record_verify(const void *log, size_t size);
+
+// Check a log and call cb for each valid record's payload in order,
+// stopping early if cb returns non-zero
+//
+// Returns the offset replay stopped at, this is either the end of the
+// valid prefix, or the start of the record cb returned non-zero for
+size_t crc32c_record_replay(const void *log, size_t size,
+        int (*cb)(void *ctx, const void *payload, size_t size),
+        void *ctx);
+
+#endif
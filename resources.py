@@ -0,0 +1,209 @@
+#!/usr/bin/env python3
+#
+# Break each kernel's static resources down from its object file: code,
+# literal pool, stack frame, vector register spills, and how much of the
+# code is the cold byte/word fallback
+#
+# Loops are found from backward branches in the disassembly. The hot loop
+# is the loop with the widest loads (128-bit vector loads beat words beat
+# bytes), with ties going to the bigger loop, and any other loop with
+# narrower loads is counted as cold fallback. Any spill (vpush/vpop or a
+# vector load/store to sp) inside the hot loop is flagged, outside of it a
+# spill only costs us once per call.
+#
+# Stack frames come from the .ci files next to each object, the same as
+# stack.py.
+#
+
+import os
+import re
+import shlex
+import subprocess
+import collections as co
+
+import stack
+
+
+OBJDUMP = 'arm-none-eabi-objdump -marmv8.1-m.main'
+
+# instruction lines in objdump -d output, address, encoding, mnemonic
+INS_PATTERN = re.compile(
+    r'^\s*([0-9a-f]+):\s+((?:[0-9a-f]{2,8} )+)\s*(\S+)\s*(.*?)\s*$')
+FUNC_PATTERN = re.compile(r'^[0-9a-f]+ <([^>]+)>:$')
+
+# literal pool entries, objdump shows these as data directives
+LITERAL = re.compile(r'\.(word|short|byte)$')
+# backward branches, excluding calls
+BRANCH = re.compile(
+    r'(b(eq|ne|cs|hs|cc|lo|mi|pl|vs|vc|hi|ls|ge|lt|gt|le)?|le|letp)'
+    r'(\.n|\.w)?$')
+
+# vector spills, pushes/pops and vector loads/stores to the stack
+VPUSH = re.compile(r'(vpush|vpop)(\.\d+)?$')
+VSTACK = re.compile(r'(vstr.*|vldr.*)$')
+
+# data load widths in bytes, stack/literal loads don't count
+LOADS = [
+    (re.compile(r'(vldr[bhw].*|vld[24].*)$'), 16),
+    (re.compile(r'(ldrd.*|ldm.*)$'), 8),
+    (re.compile(r'(ldrh.*|ldrsh.*)$'), 2),
+    (re.compile(r'(ldrb.*|ldrsb.*)$'), 1),
+    (re.compile(r'(ldr|ldr\.w|ldr\.n|ldrex)$'), 4),
+]
+
+Ins = co.namedtuple('Ins', 'addr size ins operands')
+Result = co.namedtuple('Result',
+    'code literals frame spills cold hot hot_spills')
+
+
+def disassemble(path, objdump=OBJDUMP):
+    """Disassemble an object, returns {function: [Ins...]}"""
+    out = subprocess.run(shlex.split(objdump) + ['-d', path],
+        check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout
+
+    functions = co.OrderedDict()
+    current = None
+    for line in out.splitlines():
+        m = FUNC_PATTERN.match(line)
+        if m:
+            current = functions.setdefault(m.group(1), [])
+            continue
+        m = INS_PATTERN.match(line)
+        if m and current is not None:
+            current.append(Ins(
+                int(m.group(1), 16),
+                len(m.group(2).replace(' ', ''))//2,
+                m.group(3),
+                m.group(4)))
+    return functions
+
+def load_width(ins):
+    # stack/literal loads aren't data
+    if re.search(r'\[(sp|pc)\b', ins.operands):
+        return 0
+    for pattern, width in LOADS:
+        if pattern.match(ins.ins):
+            return width
+    return 0
+
+def is_spill(ins):
+    if VPUSH.match(ins.ins):
+        return True
+    return bool(VSTACK.match(ins.ins)
+        and re.match(r'[qds]\d+,\s*\[sp\b', ins.operands))
+
+def find_loops(code):
+    """Find loops as (start, end) address ranges from backward branches"""
+    loops = []
+    for ins in code:
+        if not BRANCH.match(ins.ins):
+            continue
+        m = re.search(r'\b([0-9a-f]+) <', ins.operands)
+        if not m:
+            continue
+        target = int(m.group(1), 16)
+        if target <= ins.addr:
+            loops.append((target, ins.addr + ins.size))
+    return loops
+
+def analyze(code, **args):
+    literals = sum(ins.size for ins in code if LITERAL.match(ins.ins))
+    total = sum(ins.size for ins in code)
+    spills = sum(1 for ins in code if is_spill(ins))
+
+    def inside(loop):
+        return [ins for ins in code if loop[0] <= ins.addr < loop[1]]
+
+    # rank loops by widest load, then size
+    loops = []
+    for loop in find_loops(code):
+        body = inside(loop)
+        width = max((load_width(ins) for ins in body), default=0)
+        loops.append((width, loop[1]-loop[0], loop))
+
+    if args.get('loop'):
+        hot = next((l for l in loops if l[2][0] == int(args['loop'], 0)),
+            None)
+    else:
+        hot = max(loops, default=None)
+
+    cold = 0
+    hot_spills = 0
+    if hot:
+        hot_spills = sum(1 for ins in inside(hot[2]) if is_spill(ins))
+        # cold loops, merging any overlap
+        seen = set()
+        for width, _, loop in loops:
+            if width < hot[0] and not (
+                    loop[0] <= hot[2][0] and hot[2][1] <= loop[1]):
+                seen.update(ins.addr for ins in inside(loop))
+        cold = sum(ins.size for ins in code if ins.addr in seen)
+
+    return Result(
+        code=total - literals,
+        literals=literals,
+        frame=None,
+        spills=spills,
+        cold=cold,
+        hot=hot[2] if hot else None,
+        hot_spills=hot_spills)
+
+def main(paths, **args):
+    results = co.OrderedDict()
+    for path in paths:
+        functions = disassemble(path, args.get('objdump') or OBJDUMP)
+
+        # stack frames from the matching .ci file, if we have one
+        frames = {}
+        ci = re.sub(r'\.o$', '.ci', path)
+        if os.path.exists(ci):
+            for _, function, frame, _, _ in stack.collect([ci], quiet=True):
+                frames[function] = frame
+
+        for function, code in functions.items():
+            if not code:
+                continue
+            r = analyze(code, **args)
+            results[function] = r._replace(frame=frames.get(function))
+
+    print('%-42s %7s %7s %7s %7s %7s %6s' % (
+        '', 'code', 'lits', 'frame', 'vspill', 'cold', 'cold%'))
+    flagged = []
+    for function, r in results.items():
+        print('%-42s %7d %7d %7s %7d %7d %5.1f%%%s' % (
+            function,
+            r.code,
+            r.literals,
+            r.frame if r.frame is not None else '-',
+            r.spills,
+            r.cold,
+            100*r.cold / r.code if r.code else 0,
+            ' !' if r.hot_spills else ''))
+        if r.hot_spills:
+            flagged.append((function, r))
+
+        if args.get('verbose') and r.hot:
+            print('%42s hot loop 0x%x-0x%x' % ('', *r.hot))
+
+    for function, r in flagged:
+        print('warning: %s spills q-registers in its hot loop '
+            '(0x%x-0x%x, %d spills)' % (function, *r.hot, r.hot_spills))
+
+
+if __name__ == "__main__":
+    import argparse
+    import sys
+    parser = argparse.ArgumentParser(
+        description="Report per-kernel code, literal pool, stack, vector "
+            "spills, and cold fallback code.")
+    parser.add_argument('paths', nargs='+',
+        help="Object files to analyze, stack frames come from the .ci "
+            "files next to these.")
+    parser.add_argument('--objdump',
+        help="objdump command to use, defaults to %r." % OBJDUMP)
+    parser.add_argument('-L', '--loop',
+        help="Address of the hot loop head, defaults to the loop with the "
+            "widest loads.")
+    parser.add_argument('-v', '--verbose', action='store_true',
+        help="Show where each hot loop is.")
+    sys.exit(main(**vars(parser.parse_args())))
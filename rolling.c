@@ -0,0 +1,111 @@
+// A rolling crc32c over a fixed-size window, using MVE's vmull.p16 for the
+// Barret reduction of incoming bytes
+
+#include "rolling.h"
+#include "patch.h"
+
+#include <arm_mve.h>
+
+
+static inline uint64_t pmul32(uint32_t a, uint32_t b) {
+    uint16x8_t a_v = __arm_vdupq_n_u16(a);
+    uint16x8_t b_v = __arm_vdupq_n_u16(b);
+    a_v = (uint16x8_t)__arm_vsetq_lane_u32(a, (uint32x4_t)a_v, 1);
+    a_v = (uint16x8_t)__arm_vsetq_lane_u32(a, (uint32x4_t)a_v, 3);
+    b_v = (uint16x8_t)__arm_vsetq_lane_u32(b, (uint32x4_t)b_v, 2);
+    b_v = (uint16x8_t)__arm_vsetq_lane_u32(b, (uint32x4_t)b_v, 3);
+
+    uint32x4_t x_v = __arm_vmulltq_poly_p16(a_v, b_v);
+
+    return ((uint64_t)__arm_vgetq_lane_u32(x_v, 0))
+         ^ ((uint64_t)__arm_vgetq_lane_u32(x_v, 1) << 16)
+         ^ ((uint64_t)__arm_vgetq_lane_u32(x_v, 2) << 16)
+         ^ ((uint64_t)__arm_vgetq_lane_u32(x_v, 3) << 32);
+}
+
+static inline uint32_t reduce8(uint32_t crc, uint8_t d) {
+    // Barret reduce bytes
+    crc = crc ^ d;
+    uint32_t b = (uint32_t)pmul32(crc << 24, 0xdea713f1);
+    return (crc >> 8)
+            ^ (uint32_t)(pmul32(b, 0x05ec76f1) >> 32)
+            ^ b;
+}
+
+static inline uint32_t roll(const struct crc32c_rolling *r,
+        uint32_t crc, uint8_t out, uint8_t in) {
+    return reduce8(crc, in) ^ r->table[out];
+}
+
+int crc32c_rolling_init(struct crc32c_rolling *r, size_t window) {
+    // an empty window has nothing to roll
+    if (window == 0) {
+        return CRC32C_ROLLING_INVALID;
+    }
+
+    r->crc = 0;
+    r->window = window;
+
+    // x^(8*window) shifts a byte's crc out past the end of the window
+    uint32_t k = crc32c_xpow(8*(uint64_t)window);
+    for (size_t i = 0; i < 256; i++) {
+        r->table[i] = crc32c_mulmod(reduce8(0, i), k);
+    }
+
+    // this is just the init xor shifted by the window, and the final xor
+    r->zeros = crc32c_mulmod(0xffffffff, k) ^ 0xffffffff;
+    return CRC32C_ROLLING_OK;
+}
+
+void crc32c_rolling_start(struct crc32c_rolling *r, const void *data) {
+    const uint8_t *data_ = data;
+    uint32_t crc = 0;
+    for (size_t i = 0; i < r->window; i++) {
+        crc = reduce8(crc, data_[i]);
+    }
+    r->crc = crc;
+}
+
+uint32_t crc32c_rolling_roll(struct crc32c_rolling *r,
+        uint8_t out, uint8_t in) {
+    r->crc = roll(r, r->crc, out, in);
+    return r->crc ^ r->zeros;
+}
+
+uint32_t crc32c_rolling_crc(const struct crc32c_rolling *r) {
+    return r->crc ^ r->zeros;
+}
+
+size_t crc32c_rolling_scan(const struct crc32c_rolling *r,
+        const void *data, size_t size, uint32_t mask,
+        size_t *boundaries, size_t count) {
+    const uint8_t *data_ = data;
+    if (size < r->window || count == 0) {
+        return 0;
+    }
+
+    // we can fold the final xor into what we compare against
+    uint32_t target = r->zeros & mask;
+
+    uint32_t crc = 0;
+    size_t i = 0;
+    for (; i < r->window; i++) {
+        crc = reduce8(crc, data_[i]);
+    }
+
+    size_t n = 0;
+    for (;; i++) {
+        if ((crc & mask) == target) {
+            boundaries[n] = i;
+            n += 1;
+            if (n == count) {
+                return n;
+            }
+        }
+
+        if (i >= size) {
+            return n;
+        }
+        crc = roll(r, crc, data_[i-r->window], data_[i]);
+    }
+}
@@ -0,0 +1,53 @@
+// A rolling crc32c over a fixed-size window, for content-defined chunking
+//
+// Sliding the window one byte is O(1): shift in the new byte as usual,
+// and cancel the outgoing byte with a table of each byte's contribution
+// after window bytes, crc(b) * x^(8*window) mod P.
+
+#ifndef ROLLING_H
+#define ROLLING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+struct crc32c_rolling {
+    // crc of the current window, with no init/final xor
+    uint32_t crc;
+    // crc32c of window zero bytes, to convert crc into a real crc32c
+    uint32_t zeros;
+    size_t window;
+    // contribution of each outgoing byte
+    uint32_t table[256];
+};
+
+// crc32c_rolling_* errors
+enum {
+    CRC32C_ROLLING_OK      = 0,
+    CRC32C_ROLLING_INVALID = -1,
+};
+
+// Prepare a rolling crc32c with the given window size in bytes, this
+// builds the outgoing byte table, window must be at least 1
+int crc32c_rolling_init(struct crc32c_rolling *r, size_t window);
+
+// Start the window at data, which must contain at least window bytes
+void crc32c_rolling_start(struct crc32c_rolling *r, const void *data);
+
+// Slide the window one byte, out is the oldest byte in the window, in is
+// the new byte, returns the crc32c of the new window
+uint32_t crc32c_rolling_roll(struct crc32c_rolling *r, uint8_t out, uint8_t in);
+
+// Returns the crc32c of the current window
+uint32_t crc32c_rolling_crc(const struct crc32c_rolling *r);
+
+// Scan data for boundaries, positions p where the crc32c of the window
+// ending at p, [p-window, p), satisfies (crc & mask) == 0
+//
+// Writes at most count boundaries, returns the number written. r is only
+// used for its table, to scan a stream, overlap buffers by window-1 bytes.
+size_t crc32c_rolling_scan(const struct crc32c_rolling *r,
+        const void *data, size_t size, uint32_t mask,
+        size_t *boundaries, size_t count);
+
+#endif
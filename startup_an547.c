@@ -0,0 +1,89 @@
+// Minimal bare-metal startup for QEMU's mps3-an547 (Cortex-M55 SSE-300),
+// see an547.ld for the memory map
+//
+// Output goes through newlib's rdimon, which talks to the host over
+// semihosting, so this runs under qemu-system-arm with
+// -semihosting-config enable=on.
+
+#include <stdint.h>
+#include <stdlib.h>
+
+
+#define CPACR     (*(volatile uint32_t*)0xe000ed88)
+#define SYST_CSR  (*(volatile uint32_t*)0xe000e010)
+#define SYST_RVR  (*(volatile uint32_t*)0xe000e014)
+#define SYST_CVR  (*(volatile uint32_t*)0xe000e018)
+
+extern int main(void);
+extern void initialise_monitor_handles(void);
+
+extern uint32_t __bss_start__[];
+extern uint32_t __bss_end__[];
+// not a function, but this lets us put it in the vector table without
+// upsetting -pedantic
+extern void __stack_top(void);
+
+
+// SysTick counts the processor clock, we count wraparounds to get a
+// 32-bit timer out of SysTick's 24-bit counter
+static volatile uint32_t systick_wraps = 0;
+
+void SysTick_Handler(void) {
+    systick_wraps += 1;
+}
+
+uint32_t ticks(void) {
+    uint32_t wraps;
+    uint32_t cvr;
+    do {
+        wraps = systick_wraps;
+        cvr = SYST_CVR;
+    } while (wraps != systick_wraps);
+
+    return (wraps << 24) | (0xffffff - cvr);
+}
+
+void Default_Handler(void) {
+    // no one is around to debug us, so just bail with an error
+    _Exit(-1);
+}
+
+void Reset_Handler(void) {
+    // enable the FPU/MVE, CP10 and CP11
+    CPACR |= 0xf << 20;
+    __asm__ volatile ("dsb; isb" ::: "memory");
+
+    // zero .bss, .data is loaded in place by QEMU
+    for (uint32_t *p = __bss_start__; p < __bss_end__; p++) {
+        *p = 0;
+    }
+
+    // start SysTick free-running off the processor clock
+    SYST_RVR = 0xffffff;
+    SYST_CVR = 0;
+    SYST_CSR = 0x7;
+
+    initialise_monitor_handles();
+    exit(main());
+}
+
+
+__attribute__((section(".vectors"), used))
+static void (*const vectors[16])(void) = {
+    __stack_top,
+    Reset_Handler,
+    Default_Handler, // NMI
+    Default_Handler, // HardFault
+    Default_Handler, // MemManage
+    Default_Handler, // BusFault
+    Default_Handler, // UsageFault
+    Default_Handler, // SecureFault
+    0,
+    0,
+    0,
+    Default_Handler, // SVCall
+    Default_Handler, // DebugMonitor
+    0,
+    Default_Handler, // PendSV
+    SysTick_Handler,
+};
@@ -0,0 +1,110 @@
+// Single-bit error correction for crc32c protected blocks, the discrete
+// log is solved with baby-step giant-step using crc32c_mulmod
+
+#include "syndrome.h"
+#include "patch.h"
+
+
+extern uint32_t crc32c_folding_vmullp16_8x16wide(
+        uint32_t crc, const void *data, size_t size);
+
+static inline uint32_t hash(uint32_t x) {
+    return (x * 0x9e3779b1) >> 23;
+}
+
+static inline uint32_t xmul(uint32_t x) {
+    // multiply by x, bit-reflected this is a shift right, reducing by P
+    // if the x^31 term overflows
+    return (x >> 1) ^ ((x & 1) ? 0x82f63b78 : 0);
+}
+
+static inline uint32_t xdiv(uint32_t x) {
+    // divide by x, if the x^0 term is set we add P first, which always
+    // has an x^0 term, and the x^32 term ends up as x^31
+    return (x & 0x80000000)
+            ? ((x ^ 0x82f63b78) << 1) | 1
+            : x << 1;
+}
+
+void crc32c_syndrome_init(struct crc32c_syndrome *s) {
+    for (size_t i = 0; i < CRC32C_SYNDROME_SLOTS; i++) {
+        s->keys[i] = 0;
+    }
+
+    // baby steps, x^i for i < CRC32C_SYNDROME_BABY
+    uint32_t x = 0x80000000;
+    uint32_t giant = 0x80000000;
+    for (size_t i = 0; i < CRC32C_SYNDROME_BABY; i++) {
+        uint32_t j = hash(x) % CRC32C_SYNDROME_SLOTS;
+        while (s->keys[j]) {
+            j = (j + 1) % CRC32C_SYNDROME_SLOTS;
+        }
+        s->keys[j] = x;
+        s->steps[j] = i;
+
+        x = xmul(x);
+        giant = xdiv(giant);
+    }
+
+    s->giant = giant;
+}
+
+int crc32c_syndrome_locate(const struct crc32c_syndrome *s,
+        uint32_t syndrome, size_t size, size_t *bit) {
+    if (!syndrome) {
+        return -1;
+    }
+
+    // giant steps, syndrome * x^-(i*CRC32C_SYNDROME_BABY) until we find a
+    // baby step, this gives us n = i*CRC32C_SYNDROME_BABY + j
+    uint64_t bits = 8*(uint64_t)size + 32;
+    uint32_t x = syndrome;
+    for (uint64_t i = 0; i < bits; i += CRC32C_SYNDROME_BABY) {
+        uint32_t j = hash(x) % CRC32C_SYNDROME_SLOTS;
+        while (s->keys[j]) {
+            if (s->keys[j] == x) {
+                uint64_t n = i + s->steps[j];
+                if (n >= bits) {
+                    return -1;
+                }
+
+                // n counts from the end of the crc
+                *bit = bits-1 - n;
+                return 0;
+            }
+            j = (j + 1) % CRC32C_SYNDROME_SLOTS;
+        }
+
+        x = crc32c_mulmod(x, s->giant);
+    }
+
+    return -1;
+}
+
+int crc32c_syndrome_correct(const struct crc32c_syndrome *s,
+        void *data, size_t size, uint32_t *crc, size_t *bit) {
+    uint8_t *data_ = data;
+    uint32_t syndrome = crc32c_folding_vmullp16_8x16wide(0, data, size)
+            ^ *crc;
+    if (!syndrome) {
+        return CRC32C_SYNDROME_OK;
+    }
+
+    size_t bit_;
+    int err = crc32c_syndrome_locate(s, syndrome, size, &bit_);
+    if (err) {
+        return CRC32C_SYNDROME_UNCORRECTABLE;
+    }
+
+    if (bit) {
+        *bit = bit_;
+    }
+
+    if (bit_ >= 8*size) {
+        *crc ^= syndrome;
+        return CRC32C_SYNDROME_CRC;
+    } else {
+        data_[bit_/8] ^= 1 << (bit_%8);
+        return CRC32C_SYNDROME_DATA;
+    }
+}
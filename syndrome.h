@@ -0,0 +1,64 @@
+// Single-bit error correction for crc32c protected blocks
+//
+// If exactly one bit of a block or its crc32c flipped, the syndrome,
+// crc32c(block) ^ crc, is x^n mod P, where n is that bit's distance from
+// the end of the block. Finding n is a discrete log, which we solve with
+// baby-step giant-step over a small hash table of x^i mod P.
+//
+// crc32c has a Hamming distance of at least 4 up to 2^31 bits, so no two
+// single-bit errors share a syndrome, and double-bit errors are detected
+// but not corrected. Three or more flipped bits may be silently
+// "corrected" into the wrong block if they happen to alias.
+
+#ifndef SYNDROME_H
+#define SYNDROME_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+// number of baby steps, each giant step covers this many bits
+#define CRC32C_SYNDROME_BABY 256
+
+// hash table size, must be a power of 2 bigger than CRC32C_SYNDROME_BABY
+#define CRC32C_SYNDROME_SLOTS 512
+
+struct crc32c_syndrome {
+    // x^-CRC32C_SYNDROME_BABY mod P
+    uint32_t giant;
+    // x^i mod P -> i for i < CRC32C_SYNDROME_BABY, x^i is never zero, so
+    // zero marks an empty slot
+    uint32_t keys[CRC32C_SYNDROME_SLOTS];
+    uint16_t steps[CRC32C_SYNDROME_SLOTS];
+};
+
+// crc32c_syndrome_correct results
+enum {
+    CRC32C_SYNDROME_UNCORRECTABLE = -1,
+    CRC32C_SYNDROME_OK            = 0,
+    CRC32C_SYNDROME_DATA          = 1,
+    CRC32C_SYNDROME_CRC           = 2,
+};
+
+// Build the baby-step table, this doesn't depend on the block size so
+// one table works for all blocks
+void crc32c_syndrome_init(struct crc32c_syndrome *s);
+
+// Find the bit a syndrome points to in a size byte block followed by its
+// 32-bit crc, bits are numbered from the start of the block, LSB first,
+// so bit >= 8*size is in the crc
+//
+// Returns 0 on success, -1 if this isn't a single-bit error
+int crc32c_syndrome_locate(const struct crc32c_syndrome *s,
+        uint32_t syndrome, size_t size, size_t *bit);
+
+// Check a block against its crc32c, flipping a single bit in either the
+// block or crc if that fixes it, bit is optional
+//
+// Returns CRC32C_SYNDROME_OK if the block was already correct,
+// CRC32C_SYNDROME_DATA or CRC32C_SYNDROME_CRC if a bit was corrected, or
+// CRC32C_SYNDROME_UNCORRECTABLE
+int crc32c_syndrome_correct(const struct crc32c_syndrome *s,
+        void *data, size_t size, uint32_t *crc, size_t *bit);
+
+#endif